@@ -4,56 +4,56 @@ out vec4 FragColor;
 in vec3 normal;
 in vec2 tex_coords;
 in vec3 frag_position;
+flat in uint object_index;
 
-struct Texture
+const int TEXTURE_DIFFUSE = 0;
+const int TEXTURE_SPECULAR = 1;
+const int TEXTURE_EMISSIVE = 2;
+
+// matches OglObject in ogl_renderer.hpp
+struct Object
 {
-    sampler2D texture;
-    bool enabled;
-    float strength;
-    float scale;
+    mat4 pvm;
+    mat4 model;
+    mat4 normal_matrix;
+    vec4 color;
+    // x = enabled, y = scale, z = strength
+    vec4 textures[3];
 };
 
-layout(std140, binding = 0) uniform Material
+layout(std430, binding = 1) readonly buffer Objects
 {
-    vec3 color;
-    Texture diffuse;
-    Texture specular;
-    Texture emissive;
+    Object objects[];
 };
-//
-//struct Material
-//{
-//    vec3 color;
-//    Texture diffuse;
-//    Texture specular;
-//    Texture emissive;
-//};
+
+uniform sampler2D material_textures[3];
 
 const int LIGHT_DIRECTION = 0;
 const int LIGHT_SPOT = 1;
 const int LIGHT_POINT = 2;
 
+// matches OglLight in ogl_renderer.hpp, the scalars fill the padding after each vec3
 struct Light
 {
     vec3  position;
+    float max_distance;
     vec3  direction;
+    float cutoff;
     vec3  color;
-
     float intensity;
-    float cutoff;
-    float outer_cutoff;
-    float max_distance;
-
-    bool enabled;
 
-    int type;
+    float outer_cutoff;
+    int   type;
+    int   enabled;
 };
 
-vec4 get_texture(Texture t, vec4 default_value)
+vec4 get_texture(int type, vec4 default_value)
 {
-    if (t.enabled)
+    vec4 properties = objects[object_index].textures[type];
+
+    if (properties.x != 0)
     {
-        return texture(t.texture, tex_coords * t.scale);
+        return texture(material_textures[type], tex_coords * properties.y);
     }
     else
     {
@@ -61,10 +61,13 @@ vec4 get_texture(Texture t, vec4 default_value)
     }
 }
 
-#define MAX_LIGHTS 16
 
-uniform Material material;
-uniform Light[MAX_LIGHTS] lights;
+layout(std430, binding = 0) readonly buffer Lights
+{
+    // one past the highest enabled light
+    uint light_count;
+    Light lights[];
+};
 
 uniform vec3 view_position;
 
@@ -89,10 +92,10 @@ LightingResult calculate_lighting(Light light, vec3 light_direction)
     vec3 view_direction = normalize(view_position - frag_position);
     vec3 reflection_direction = reflect(-light_direction, normal);
 
-    float specular_factor = pow(max(dot(view_direction, reflection_direction), 0.0), material.specular.strength);
-    vec3 specular = light.color * specular_factor * get_texture(material.specular, vec4(0)).rgb;
+    float specular_factor = pow(max(dot(view_direction, reflection_direction), 0.0), objects[object_index].textures[TEXTURE_SPECULAR].z);
+    vec3 specular = light.color * specular_factor * get_texture(TEXTURE_SPECULAR, vec4(0)).rgb;
 
-    vec3 emissive = get_texture(material.emissive, vec4(0.0)).rgb * material.emissive.strength;
+    vec3 emissive = get_texture(TEXTURE_EMISSIVE, vec4(0.0)).rgb * objects[object_index].textures[TEXTURE_EMISSIVE].z;
 
     return LightingResult(ambient, diffuse, specular, emissive, light.intensity);
 }
@@ -148,7 +151,7 @@ vec3 calculate_point_spot_light(Light light)
 
 void main()
 {
-    g_object_color = get_texture(material.diffuse, vec4(1.0)) * vec4(material.color, 1.0);
+    g_object_color = get_texture(TEXTURE_DIFFUSE, vec4(1.0)) * objects[object_index].color;
 
     if (g_object_color.a < 0.1)
     {
@@ -157,11 +160,11 @@ void main()
 
     vec3 result = vec3(0.0);
 
-    for (int i = 0; i < MAX_LIGHTS; i++)
+    for (uint i = 0; i < light_count; i++)
     {
         Light light = lights[i];
 
-        if (light.enabled)
+        if (light.enabled != 0)
         {
             if (light.type == LIGHT_DIRECTION)
             {
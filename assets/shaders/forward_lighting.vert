@@ -6,16 +6,32 @@ layout (location = 2) in vec3 a_normal;
 out vec3 normal;
 out vec2 tex_coords;
 out vec3 frag_position;
+flat out uint object_index;
 
-uniform mat4 pvm;
-uniform mat4 model;
-uniform mat4 normal_matrix;
+// matches OglObject in ogl_renderer.hpp
+struct Object
+{
+    mat4 pvm;
+    mat4 model;
+    mat4 normal_matrix;
+    vec4 color;
+    // x = enabled, y = scale, z = strength
+    vec4 textures[3];
+};
+
+layout(std430, binding = 1) readonly buffer Objects
+{
+    Object objects[];
+};
 
 void main()
 {
+    // every draw command carries the index of its object in base_instance
+    object_index    = gl_BaseInstance;
+
     tex_coords      = a_tex_coords;
-    normal          = mat3(normal_matrix) * a_normal;
-    frag_position   = vec3(model * vec4(a_pos, 1.0));
+    normal          = mat3(objects[object_index].normal_matrix) * a_normal;
+    frag_position   = vec3(objects[object_index].model * vec4(a_pos, 1.0));
 
-    gl_Position = pvm * vec4(a_pos, 1.0);
+    gl_Position = objects[object_index].pvm * vec4(a_pos, 1.0);
 }
@@ -1,10 +1,18 @@
 
 
 #include <iostream>
-#include <forge/framework/components/mesh_primitive_component.hpp>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "cpu_benchmark.hpp"
 #include "forge/editor/editor_subsystem.hpp"
+#include "forge/math/transform.hpp"
+#include "forge/math/transform_kernel.hpp"
+#include "forge/memory/defs.hpp"
+#include "forge/memory/mem_pool.hpp"
+#include "forge/system/virtual_memory.hpp"
 
 #include "forge/util/random.hpp"
 
@@ -47,6 +55,284 @@ public:
 	}
 };
 
+// compares computing global matrices one transform at a time against the batched soa kernel
+void run_transform_benchmark()
+{
+	Benchmarker bench;
+
+	constexpr auto COUNT = 1'000'000;
+
+	std::vector<forge::Transform> transforms;
+	transforms.resize(COUNT);
+
+	forge::TransformSoA soa;
+	soa.resize(COUNT);
+
+	std::vector<const glm::mat4*> parents(COUNT);
+	std::vector<glm::mat4*> outputs(COUNT);
+
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		auto &transform = transforms[i];
+
+		transform.set_local_position(util::rand_vec3(-100, 100));
+		transform.rotate(util::rand_float(0, 360), util::rand_float(0, 360), util::rand_float(0, 360));
+		transform.set_scale(util::rand_vec3(0.5f, 2));
+
+		// every other transform is the child of the one before it
+		transform.parent = i % 2 == 1 ? &transforms[i - 1] : nullptr;
+
+		soa.set(i, transform.get_local_position(), transform.get_local_rotation(), transform.get_scale());
+		parents[i] = transform.parent ? &transform.parent->get_global_matrix_storage() : nullptr;
+		outputs[i] = &transform.get_global_matrix_storage();
+	}
+
+	bench.cases.emplace_back("Transform T * R * S",
+	[&transforms]
+	{
+		for (auto &transform : transforms)
+		{
+			glm::mat4 identity {1.0f};
+
+			auto local = glm::translate(identity, transform.get_local_position()) *
+				glm::toMat4(transform.get_local_rotation()) * glm::scale(identity, transform.get_scale());
+
+			transform.get_global_matrix_storage() = transform.parent ? transform.parent->get_global_matrix() * local : local;
+		}
+	});
+
+	bench.cases.emplace_back("Transform compute_global",
+	[&transforms]
+	{
+		for (auto &transform : transforms)
+		{
+			transform.compute_global();
+		}
+	});
+
+	bench.cases.emplace_back("Transform kernel scalar",
+	[&]
+	{
+		forge::compute_global_matrices(soa, parents.data(), outputs.data(), 0, COUNT, forge::SimdLevel::Scalar);
+	});
+
+	const auto level = forge::get_supported_simd_level();
+
+	if (level >= forge::SimdLevel::Sse)
+	{
+		bench.cases.emplace_back("Transform kernel sse",
+		[&]
+		{
+			forge::compute_global_matrices(soa, parents.data(), outputs.data(), 0, COUNT, forge::SimdLevel::Sse);
+		});
+	}
+
+	if (level >= forge::SimdLevel::Avx2)
+	{
+		bench.cases.emplace_back("Transform kernel avx2",
+		[&]
+		{
+			forge::compute_global_matrices(soa, parents.data(), outputs.data(), 0, COUNT, forge::SimdLevel::Avx2);
+		});
+	}
+
+	bench.run_cases(20);
+	bench.display_results();
+}
+
+// allocates and frees batches of random sizes over and over. the mapped memory the pool ends up using should stay
+// close to the most elements that were alive at once instead of growing with every round
+void run_mem_pool_churn_benchmark()
+{
+	Benchmarker bench;
+
+	struct Element
+	{
+		u8 data[64];
+	};
+
+	constexpr auto MAX_LIVE = 50'000;
+	constexpr auto ROUNDS = 2'000;
+
+	forge::MemPool pool;
+	pool.init<Element>(MB(48));
+
+	std::vector<std::pair<size_t, u32>> live;
+	size_t live_count = 0;
+	size_t peak_live = 0;
+	size_t peak_offset = 0;
+
+	srand(1);
+
+	bench.cases.emplace_back("MemPool churn",
+	[&]
+	{
+		for (auto round = 0; round < ROUNDS; round++)
+		{
+			const auto count = util::rand_range<u32>(1, 64);
+
+			if (live_count + count <= MAX_LIVE)
+			{
+				auto [_, offset] = pool.allocate(count);
+
+				live.emplace_back(offset, count);
+				live_count += count;
+			}
+
+			// once half of the limit is reached free about as much as gets allocated so the live amount hovers around it
+			if (!live.empty() && (live_count > MAX_LIVE / 2 || rand() % 4 == 0))
+			{
+				const auto index = util::rand_range<size_t>(0, live.size() - 1);
+				const auto [offset, freed] = live[index];
+
+				for (u32 i = 0; i < freed; i++)
+				{
+					pool.free(offset + i * sizeof(Element));
+				}
+
+				live[index] = live.back();
+				live.pop_back();
+				live_count -= freed;
+			}
+
+			peak_live = std::max(peak_live, live_count);
+			peak_offset = std::max(peak_offset, pool.get_offset());
+		}
+	});
+
+	bench.run_cases(100);
+	bench.display_results();
+
+	std::cout << "MemPool churn peak live: " << peak_live * sizeof(Element) / 1024 << "KB, peak mapped: "
+		<< peak_offset / 1024 << "KB\n";
+}
+
+volatile u64 g_benchmark_sink;
+
+// counts data tlb misses of the calling thread, reads -1 if perf events are not available
+struct DtlbMissCounter
+{
+	int fd = -1;
+
+	DtlbMissCounter()
+	{
+		perf_event_attr attr {};
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.exclude_kernel = 1;
+
+		fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+
+	~DtlbMissCounter()
+	{
+		if (fd != -1)
+		{
+			close(fd);
+		}
+	}
+
+	long read_count() const
+	{
+		long count = -1;
+
+		if (fd == -1 || read(fd, &count, sizeof(count)) != sizeof(count))
+		{
+			return -1;
+		}
+
+		return count;
+	}
+};
+
+long get_minor_page_faults()
+{
+	rusage usage {};
+	getrusage(RUSAGE_THREAD, &usage);
+
+	return usage.ru_minflt;
+}
+
+// maps a large pool with each set of flags, writes all of it and then reads it at random. shows how many page faults
+// the first touch takes, how long the mapping takes and how many tlb misses random access causes afterwards
+void run_virtual_alloc_benchmark()
+{
+	constexpr size_t POOL_SIZE = MB(512);
+	constexpr auto RANDOM_READS = 20'000'000;
+
+	struct Config
+	{
+		const char *label;
+		u8 flags;
+	};
+
+	const Config configs[] =
+	{
+		{"default", forge::VirtualAllocFlags::None},
+		{"no reserve", forge::VirtualAllocFlags::NoReserve},
+		{"huge pages", forge::VirtualAllocFlags::HugePages},
+		{"populate", forge::VirtualAllocFlags::Populate},
+		{"huge pages + populate", forge::VirtualAllocFlags::HugePages | forge::VirtualAllocFlags::Populate},
+		{"local node + populate", forge::VirtualAllocFlags::LocalNode | forge::VirtualAllocFlags::Populate},
+	};
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	DtlbMissCounter tlb_misses;
+
+	for (const auto &config : configs)
+	{
+		auto faults = get_minor_page_faults();
+		auto start = Clock::now();
+
+		auto *memory = forge::virtual_alloc(POOL_SIZE, config.flags);
+
+		const auto map_time = Clock::now() - start;
+		const auto map_faults = get_minor_page_faults() - faults;
+
+		faults = get_minor_page_faults();
+		start = Clock::now();
+
+		for (size_t offset = 0; offset < POOL_SIZE; offset += 64)
+		{
+			memory[offset] = (u8)offset;
+		}
+
+		const auto touch_time = Clock::now() - start;
+		const auto touch_faults = get_minor_page_faults() - faults;
+
+		u64 state = 1;
+		u64 sum = 0;
+
+		const auto misses = tlb_misses.read_count();
+		start = Clock::now();
+
+		for (auto i = 0; i < RANDOM_READS; i++)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			sum += memory[(state >> 16) % POOL_SIZE];
+		}
+
+		const auto read_time = Clock::now() - start;
+
+		// keeps the reads from being optimized out
+		g_benchmark_sink = sum;
+		const auto read_misses = misses == -1 ? -1 : tlb_misses.read_count() - misses;
+
+		forge::virtual_free(memory);
+
+		auto to_ms = [](auto duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		};
+
+		std::cout << config.label << ": map " << to_ms(map_time) << "ms (" << map_faults << " faults), first touch "
+			<< to_ms(touch_time) << "ms (" << touch_faults << " faults), random reads " << to_ms(read_time) << "ms ("
+			<< (read_misses == -1 ? std::string("n/a") : std::to_string(read_misses)) << " dtlb misses)\n";
+	}
+}
+
 int main()
 {
 	Benchmarker bench;
@@ -79,4 +365,8 @@ int main()
 
 	bench.run_cases(100);
 	bench.display_results();
+
+	run_transform_benchmark();
+	run_mem_pool_churn_benchmark();
+	run_virtual_alloc_benchmark();
 }
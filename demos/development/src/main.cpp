@@ -238,6 +238,7 @@ struct TransformDirtierComponent : forge::IComponent
 struct CounterComponent : forge::IComponent
 {
 	REGISTER_UPDATE_FUNC
+	COMPACT_STORAGE
 
 	forge::DeltaTime counter {};
 
@@ -277,10 +278,10 @@ void ecs_stress_test()
 	auto dirtier_counter = 0;
 	auto dirtier_limit = TOP_LEVEL_ENTITIES * 0.002;
 
-	for (int i = 0; i < TOP_LEVEL_ENTITIES; i++)
-	{
-		auto *entity = g_engine.nexus->create_entity<CounterComponent, CounterComponent2, CounterComponent3>();
+	auto entities = g_engine.nexus->create_entities<CounterComponent, CounterComponent2, CounterComponent3>(TOP_LEVEL_ENTITIES);
 
+	for (auto *entity : entities)
+	{
 		dirtier_counter++;
 
 		if (dirtier_counter >= dirtier_limit)
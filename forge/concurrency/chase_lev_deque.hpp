@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace forge
+{
+	// fixed size work stealing deque (Chase-Lev, using the memory orders from "Correct and Efficient Work-Stealing
+	// for Weak Memory Models"). only the owning thread may push and pop, any thread may steal.
+	// the owner works on the bottom in lifo order while thieves take from the top
+	template<class T, size_t Capacity>
+	class ChaseLevDeque
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+		static constexpr i64 MASK = Capacity - 1;
+
+	public:
+		// returns false if the deque is full
+		bool push(T *value)
+		{
+			const auto bottom = m_bottom.load(std::memory_order_relaxed);
+			const auto top = m_top.load(std::memory_order_acquire);
+
+			if (bottom - top >= (i64)Capacity)
+			{
+				return false;
+			}
+
+			m_buffer[bottom & MASK].store(value, std::memory_order_relaxed);
+
+			// publishes the element and everything written to it before the push to thieves
+			m_bottom.store(bottom + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		T* pop()
+		{
+			const auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+
+			m_bottom.store(bottom, std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			auto top = m_top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			auto *value = m_buffer[bottom & MASK].load(std::memory_order_relaxed);
+
+			// last element so race against thieves for it
+			if (top == bottom)
+			{
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					value = nullptr;
+				}
+
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			return value;
+		}
+
+		T* steal()
+		{
+			auto top = m_top.load(std::memory_order_acquire);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			const auto bottom = m_bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+			{
+				return nullptr;
+			}
+
+			auto *value = m_buffer[top & MASK].load(std::memory_order_relaxed);
+
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+
+			return value;
+		}
+
+	private:
+		// kept on separate cache lines since the owner hammers bottom and thieves hammer top
+		alignas(64) std::atomic<i64> m_top {0};
+		alignas(64) std::atomic<i64> m_bottom {0};
+		alignas(64) std::array<std::atomic<T*>, Capacity> m_buffer {};
+	};
+}
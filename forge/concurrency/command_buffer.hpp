@@ -1,56 +1,214 @@
 #pragma once
+
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "forge/memory/defs.hpp"
+#include "forge/memory/mem_utils.hpp"
+
+// the amount of memory each of the two buffers has for storing commands inline. commands that don't fit are heap allocated
+#define COMMAND_BUFFER_ARENA_SIZE KB(64)
 
 namespace forge
 {
+	// multi producer single consumer command queue. any thread can emplace commands without taking a lock,
+	// commands are stored inline in a linear arena and linked into a lock free list.
+	// emplacing always goes to the active buffer while execute_all swaps buffers and runs the previous one,
+	// so commands emplaced while executing will run on the next call. only one thread may call execute_all at a time
 	template<class ...Args>
 	class CommandBuffer
 	{
 	public:
 		using Callback = std::function<void(Args...)>;
 
-		void emplace(Callback &&command)
+		CommandBuffer()
+		{
+			for (auto &buffer : m_buffers)
+			{
+				buffer.arena = std::make_unique<u8[]>(COMMAND_BUFFER_ARENA_SIZE);
+			}
+		}
+
+		~CommandBuffer()
 		{
-			std::lock_guard lock {m_mutex};
+			for (auto &buffer : m_buffers)
+			{
+				destroy_all(buffer.head.exchange(nullptr));
+			}
+		}
+
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		template<class Fn>
+		void emplace(Fn &&command)
+		{
+			using F = std::decay_t<Fn>;
+
+			auto &buffer = acquire_active_buffer();
+
+			constexpr auto alignment = std::max(alignof(Command), alignof(F));
+			constexpr auto payload_offset = align_to(sizeof(Command), alignof(F));
+			constexpr auto size = payload_offset + sizeof(F);
 
-			auto &buffer = get_active_buffer();
+			auto *memory = allocate(buffer, size, alignment);
+			auto is_heap = memory == nullptr;
 
-			buffer.emplace_back(std::forward<Callback>(command));
+			if (is_heap)
+			{
+				memory = (u8*)::operator new(size, std::align_val_t{alignment});
+			}
+
+			new (memory + payload_offset) F(std::forward<Fn>(command));
+
+			auto *node = new (memory) Command
+			{
+				.invoke = [](Command *node, Args &...args)
+				{
+					auto *function = (F*)((u8*)node + payload_offset);
+
+					(*function)(args...);
+					function->~F();
+				},
+				.destroy = [](Command *node)
+				{
+					((F*)((u8*)node + payload_offset))->~F();
+				},
+				.alignment = alignment,
+				.is_heap = is_heap,
+			};
+
+			node->next = buffer.head.load(std::memory_order_relaxed);
+
+			while (!buffer.head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+
+			buffer.writers.fetch_sub(1, std::memory_order_release);
 		}
 
 		void execute_all(Args &&...args)
 		{
-			m_mutex.lock();
+			const auto index = m_active.load(std::memory_order_relaxed);
+
+			m_active.store(index ^ 1, std::memory_order_seq_cst);
 
-			auto &buffer = get_active_buffer();
+			auto &buffer = m_buffers[index];
 
-			m_use_buffer_a = !m_use_buffer_a;
+			// producers that picked this buffer before the swap may still be linking their command
+			while (buffer.writers.load(std::memory_order_seq_cst) != 0)
+			{
+				std::this_thread::yield();
+			}
 
-			m_mutex.unlock();
+			auto *node = buffer.head.exchange(nullptr, std::memory_order_acquire);
 
-			if (buffer.empty())
+			// the list is built newest first so flip it to run the commands in the order they were emplaced
+			Command *ordered = nullptr;
+
+			while (node)
 			{
-				return;
+				auto *next = node->next;
+				node->next = ordered;
+				ordered = node;
+				node = next;
 			}
 
-			for (auto &command : buffer)
+			while (ordered)
 			{
-				command(std::forward<Args>(args)...);
+				auto *next = ordered->next;
+
+				ordered->invoke(ordered, args...);
+
+				free_command(ordered);
+
+				ordered = next;
 			}
 
-			buffer.clear();
+			buffer.offset.store(0, std::memory_order_relaxed);
 		}
 
 	private:
-		std::mutex m_mutex;
-		// TODO: its probably a good idea to use an object pool for the std::function objects
-		std::vector<Callback> m_buffer_a;
-		std::vector<Callback> m_buffer_b;
-		bool m_use_buffer_a = true;
+		struct Command
+		{
+			Command *next = nullptr;
+			// calls and then destroys the stored callable
+			void(*invoke)(Command*, Args&...);
+			void(*destroy)(Command*);
+			size_t alignment;
+			bool is_heap;
+		};
+
+		struct Buffer
+		{
+			std::unique_ptr<u8[]> arena;
+			std::atomic<size_t> offset {};
+			std::atomic<Command*> head {};
+			// the amount of producers currently writing into this buffer
+			std::atomic<u32> writers {};
+		};
+
+		Buffer m_buffers[2];
+		std::atomic<u32> m_active {};
+
+		// registers the calling thread as a writer of the active buffer. the writer count is raised before the active
+		// index is checked again so execute_all either sees the writer or the producer sees the swap and retries
+		Buffer& acquire_active_buffer()
+		{
+			while (true)
+			{
+				const auto index = m_active.load(std::memory_order_seq_cst);
+
+				auto &buffer = m_buffers[index];
+
+				buffer.writers.fetch_add(1, std::memory_order_seq_cst);
+
+				if (m_active.load(std::memory_order_seq_cst) == index)
+				{
+					return buffer;
+				}
+
+				buffer.writers.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		// returns nullptr once the arena of the buffer is full
+		static u8* allocate(Buffer &buffer, size_t size, size_t alignment)
+		{
+			// reserve enough for the worst case padding so the bump itself stays a single atomic add
+			const auto reserved = size + alignment - 1;
+			const auto offset = buffer.offset.fetch_add(reserved, std::memory_order_relaxed);
+
+			if (offset + reserved > COMMAND_BUFFER_ARENA_SIZE)
+			{
+				return nullptr;
+			}
 
-		inline std::vector<Callback>& get_active_buffer()
+			return (u8*)align_to((size_t)(buffer.arena.get() + offset), alignment);
+		}
+
+		static void free_command(Command *node)
 		{
-			return m_use_buffer_a ? m_buffer_a : m_buffer_b;
+			if (node->is_heap)
+			{
+				::operator delete(node, std::align_val_t{node->alignment});
+			}
+		}
+
+		static void destroy_all(Command *node)
+		{
+			while (node)
+			{
+				auto *next = node->next;
+
+				node->destroy(node);
+				free_command(node);
+
+				node = next;
+			}
 		}
 	};
 }
@@ -0,0 +1,202 @@
+#include "job_system.hpp"
+
+#include "forge/core/logging.hpp"
+
+std::string forge::JobSystem::init([[maybe_unused]] const EngineInitOptions &options)
+{
+	auto worker_count = m_arg_config.worker_count;
+
+	if (worker_count < 0)
+	{
+		worker_count = std::max<i32>(std::thread::hardware_concurrency(), 1) - 1;
+	}
+
+	m_thread_count = worker_count + 1;
+
+	m_queues = std::make_unique<ThreadQueue[]>(m_thread_count);
+
+	for (u32 i = 0; i < m_thread_count; i++)
+	{
+		m_queues[i].jobs = std::make_unique<Job[]>(JOB_RING_SIZE);
+		m_queues[i].in_flight = std::make_unique<std::atomic<bool>[]>(JOB_RING_SIZE);
+	}
+
+	g_job_thread_index = 0;
+
+	m_should_stop = false;
+
+	m_workers.reserve(worker_count);
+
+	for (i32 i = 0; i < worker_count; i++)
+	{
+		m_workers.emplace_back(&JobSystem::worker_loop, this, i + 1);
+	}
+
+	log::info("job system started with {} worker threads", worker_count);
+
+	return {};
+}
+
+void forge::JobSystem::shutdown()
+{
+	m_should_stop = true;
+
+	m_work_signal.fetch_add(1);
+	m_work_signal.notify_all();
+
+	for (auto &worker : m_workers)
+	{
+		worker.join();
+	}
+
+	m_workers.clear();
+	m_queues.reset();
+	m_thread_count = 1;
+
+	g_job_thread_index = JOB_FOREIGN_THREAD;
+}
+
+void forge::JobSystem::receive_cmd_args(ArgParser &parser)
+{
+	parser.add("worker_threads", &m_arg_config.worker_count,
+		{.alias = {}, .description = "how many worker threads the job system uses. negative uses all cores", .group = "jobs"});
+}
+
+void forge::JobSystem::wait(JobCounter &counter)
+{
+	const auto thread_index = g_job_thread_index;
+
+	while (!counter.is_done())
+	{
+		auto *job = thread_index == JOB_FOREIGN_THREAD ? nullptr : find_job(thread_index);
+
+		if (job)
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+forge::Job* forge::JobSystem::allocate_job()
+{
+	auto &queue = m_queues[g_job_thread_index];
+
+	const auto slot = queue.next_job & (JOB_RING_SIZE - 1);
+
+	// the owner pops its newest jobs first so an old one can sit in the deque for longer than a lap of the ring
+	if (queue.in_flight[slot].load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+
+	queue.in_flight[slot].store(true, std::memory_order_relaxed);
+	queue.next_job++;
+
+	return &queue.jobs[slot];
+}
+
+void forge::JobSystem::push(Job *job)
+{
+	if (!m_queues[g_job_thread_index].deque.push(job))
+	{
+		// the queue is full so there is plenty of work for the other threads already
+		execute(job);
+		return;
+	}
+
+	m_work_signal.fetch_add(1);
+
+	if (m_sleeping_workers.load() > 0)
+	{
+		m_work_signal.notify_one();
+	}
+}
+
+forge::Job* forge::JobSystem::find_job(u32 thread_index)
+{
+	if (auto *job = m_queues[thread_index].deque.pop())
+	{
+		return job;
+	}
+
+	const auto thread_count = get_thread_count();
+
+	for (u32 i = 1; i < thread_count; i++)
+	{
+		if (auto *job = m_queues[(thread_index + i) % thread_count].deque.steal())
+		{
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void forge::JobSystem::execute(Job *job)
+{
+	// copy it out so the ring slot can be handed out again while the job runs
+	auto copy = *job;
+
+	for (u32 i = 0; i < m_thread_count; i++)
+	{
+		auto &queue = m_queues[i];
+
+		if (job >= queue.jobs.get() && job < queue.jobs.get() + JOB_RING_SIZE)
+		{
+			queue.in_flight[job - queue.jobs.get()].store(false, std::memory_order_release);
+			break;
+		}
+	}
+
+	copy.function(copy);
+
+	copy.counter->m_value.fetch_sub(1, std::memory_order_release);
+}
+
+void forge::JobSystem::worker_loop(u32 thread_index)
+{
+	g_job_thread_index = thread_index;
+
+	u32 idle_count = 0;
+
+	while (!m_should_stop.load(std::memory_order_relaxed))
+	{
+		if (auto *job = find_job(thread_index))
+		{
+			execute(job);
+			idle_count = 0;
+			continue;
+		}
+
+		if (++idle_count < JOB_IDLE_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// read the signal before looking one more time so a push in between wakes us up right away
+		const auto signal = m_work_signal.load();
+
+		m_sleeping_workers.fetch_add(1);
+
+		if (auto *job = find_job(thread_index))
+		{
+			m_sleeping_workers.fetch_sub(1);
+			execute(job);
+			idle_count = 0;
+			continue;
+		}
+
+		if (!m_should_stop)
+		{
+			m_work_signal.wait(signal);
+		}
+
+		m_sleeping_workers.fetch_sub(1);
+		idle_count = 0;
+	}
+}
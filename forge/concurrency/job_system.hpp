@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "chase_lev_deque.hpp"
+#include "forge/container/array.hpp"
+#include "forge/core/isub_system.hpp"
+
+// the max amount of jobs a single thread can have queued at once. pushing more runs the job right away
+#define JOB_QUEUE_CAPACITY 4096
+// jobs are handed out from a ring per thread. a slot stays taken until a thread has picked its job up, when the next
+// slot is still taken the job runs right away instead
+#define JOB_RING_SIZE (JOB_QUEUE_CAPACITY * 2)
+// how many bytes a job can capture inline
+#define JOB_DATA_SIZE 48
+// how many batches parallel_for makes per thread when no batch size is given
+#define JOB_BATCHES_PER_THREAD 4
+// how many times an idle worker looks for work before going to sleep
+#define JOB_IDLE_SPIN_COUNT 64
+
+#define JOB_FOREIGN_THREAD UINT32_MAX
+
+namespace forge
+{
+	// index of the calling thread within the job system. 0 is the thread that initialized it (the main thread),
+	// workers are 1..n and threads not owned by the job system get JOB_FOREIGN_THREAD
+	inline thread_local u32 g_job_thread_index = JOB_FOREIGN_THREAD;
+
+	// counts the jobs that have been started with it and have not finished yet
+	class JobCounter
+	{
+	public:
+		[[nodiscard]]
+		inline bool is_done() const
+		{
+			return m_value.load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<u32> m_value {};
+	};
+
+	struct alignas(64) Job
+	{
+		void(*function)(Job&);
+		JobCounter *counter;
+		alignas(16) u8 data[JOB_DATA_SIZE];
+	};
+
+	struct JobSystemArgConfig
+	{
+		// a negative count uses one worker per hardware thread besides the main thread
+		i32 worker_count = -1;
+	};
+
+	// work stealing job system. every thread owns a deque of jobs, new jobs are pushed to the deque of the calling thread
+	// and idle threads steal from the others. waiting on a counter runs jobs instead of blocking
+	class JobSystem final : public ISubSystem
+	{
+	public:
+		std::string init(const EngineInitOptions &options) override;
+
+		void shutdown() override;
+
+		void update() override {}
+
+		bool should_update() override { return false; }
+
+		void receive_cmd_args(ArgParser &parser) override;
+
+		// queues fn to run on any thread. fn has to be trivially copyable and fit into JOB_DATA_SIZE bytes,
+		// capture pointers to larger state instead. runs fn right away when called from a foreign thread or when the
+		// ring of the calling thread has no free slot
+		template<class Fn>
+		void run(JobCounter &counter, Fn &&fn)
+		{
+			using F = std::decay_t<Fn>;
+
+			static_assert(sizeof(F) <= JOB_DATA_SIZE && alignof(F) <= 16, "job captures are too large");
+			static_assert(std::is_trivially_copyable_v<F>, "job captures must be trivially copyable");
+
+			counter.m_value.fetch_add(1, std::memory_order_relaxed);
+
+			auto *job = g_job_thread_index == JOB_FOREIGN_THREAD || m_queues == nullptr ? nullptr : allocate_job();
+
+			if (job == nullptr)
+			{
+				fn();
+				counter.m_value.fetch_sub(1, std::memory_order_release);
+				return;
+			}
+
+			job->function = [](Job &job)
+			{
+				(*(F*)job.data)();
+			};
+
+			job->counter = &counter;
+
+			new (job->data) F(std::forward<Fn>(fn));
+
+			push(job);
+		}
+
+		// runs jobs on the calling thread until the counter reaches zero
+		void wait(JobCounter &counter);
+
+		// calls fn(first, last) for batches that cover [0, count) and waits for all of them.
+		// a batch size of 0 splits the range evenly between the threads
+		template<class Fn>
+		void parallel_for(size_t count, size_t batch_size, Fn &&fn)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			if (batch_size == 0)
+			{
+				const size_t batch_count = get_thread_count() * JOB_BATCHES_PER_THREAD;
+				batch_size = (count + batch_count - 1) / batch_count;
+			}
+
+			if (batch_size >= count || m_thread_count == 1 || g_job_thread_index == JOB_FOREIGN_THREAD)
+			{
+				fn(size_t{0}, count);
+				return;
+			}
+
+			JobCounter counter;
+
+			auto *function = &fn;
+
+			for (size_t first = 0; first < count; first += batch_size)
+			{
+				const auto last = std::min(first + batch_size, count);
+
+				run(counter, [function, first, last]
+				{
+					(*function)(first, last);
+				});
+			}
+
+			wait(counter);
+		}
+
+		// the amount of threads that run jobs including the main thread
+		[[nodiscard]]
+		inline u32 get_thread_count() const
+		{
+			return m_thread_count;
+		}
+
+	private:
+		struct alignas(64) ThreadQueue
+		{
+			ChaseLevDeque<Job, JOB_QUEUE_CAPACITY> deque;
+			std::unique_ptr<Job[]> jobs;
+			// set while the job in the matching slot is queued and has not been picked up yet
+			std::unique_ptr<std::atomic<bool>[]> in_flight;
+			u32 next_job = 0;
+		};
+
+		JobSystemArgConfig m_arg_config;
+		std::unique_ptr<ThreadQueue[]> m_queues;
+		Array<std::thread> m_workers;
+		u32 m_thread_count = 1;
+		std::atomic<bool> m_should_stop = false;
+		// bumped whenever a job is pushed so sleeping workers know to look again
+		std::atomic<u32> m_work_signal {};
+		std::atomic<u32> m_sleeping_workers {};
+
+		// returns nullptr when the next slot in the ring is still in flight
+		Job* allocate_job();
+
+		void push(Job *job);
+
+		Job* find_job(u32 thread_index);
+
+		void execute(Job *job);
+
+		void worker_loop(u32 thread_index);
+	};
+
+	// runs parallel_for on the job system if there is one, otherwise calls fn(0, count) on the calling thread
+	template<class Fn>
+	void parallel_for(JobSystem *job_system, size_t count, size_t batch_size, Fn &&fn)
+	{
+		if (job_system == nullptr)
+		{
+			if (count > 0)
+			{
+				fn(size_t{0}, count);
+			}
+
+			return;
+		}
+
+		job_system->parallel_for(count, batch_size, std::forward<Fn>(fn));
+	}
+}
@@ -1,32 +1,69 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #include "forge/core/logging.hpp"
 #include "forge/memory/defs.hpp"
+#include "forge/memory/mem_utils.hpp"
 #include "forge/memory/virtual_allocator.hpp"
+#include "forge/system/system_info.hpp"
 #include "forge/system/virtual_memory.hpp"
 #include "forge/util/types.hpp"
 
 #define DEFAULT_VIRTUAL_ARRAY_SIZE KB(4)
+// the memory of a VirtualArray is reserved up front and committed in steps of this as it grows
+#define VIRTUAL_ARRAY_COMMIT_GRANULARITY KB(64)
+// used instead for the elements of arrays that asked for huge pages, committing less would split the huge pages up
+#define VIRTUAL_ARRAY_HUGE_PAGE_COMMIT_GRANULARITY VIRTUAL_HUGE_PAGE_SIZE
+// clear only gives the committed memory back once it got at least this large. small arrays like the children of an
+// entity get cleared all the time and would otherwise fault their pages in again every time
+#define VIRTUAL_ARRAY_DECOMMIT_THRESHOLD MB(1)
 
 namespace forge
 {
+	enum class VirtualArrayLayout : u8
+	{
+		// the free list metadata is stored right behind every element
+		Interleaved,
+		// the metadata is kept in its own array so the elements are packed back to back with a stride of sizeof(T).
+		// worth it for large elements that get swept over, the metadata would otherwise add padding to every element
+		// and sweeps that only touch the elements don't have to stream it
+		Split,
+	};
+
 	// an array backed by virtual memory that does not grow or shrink
-	template<class T, class Allocator = VirtualAllocator<T>>
+	template<class T, class Allocator = VirtualAllocator<T>, VirtualArrayLayout Layout = VirtualArrayLayout::Interleaved>
 	class VirtualArray
 	{
-		struct Header
+		static constexpr bool IS_SPLIT = Layout == VirtualArrayLayout::Split;
+		static constexpr u32 NO_SLOT = UINT32_MAX;
+
+		struct Metadata
+		{
+			bool is_free = true;
+			u32 next_free = NO_SLOT;
+		};
+
+		struct InterleavedHeader
+		{
+			alignas(T)
+			u8 memory[sizeof(T)];
+			Metadata metadata;
+		};
+
+		struct SplitHeader
 		{
 			alignas(T)
 			u8 memory[sizeof(T)];
-			bool is_free = true;
-			u32 next_free;
-			u32 offset;
 		};
 
+		using Header = std::conditional_t<IS_SPLIT, SplitHeader, InterleavedHeader>;
+
 	public:
 		class Iterator;
 
@@ -36,12 +73,19 @@ namespace forge
 			bool reused = false;
 		};
 
+		VirtualArray() = default;
+
+		// copies would free the memory of the original once destroyed
+		VirtualArray(const VirtualArray &) = delete;
+		VirtualArray& operator=(const VirtualArray &) = delete;
+
 		bool is_initialized() const
 		{
 			return m_memory != nullptr;
 		}
 
-		void init(i32 max_elements = -1)
+		// flags only apply to the elements, see VirtualAllocFlags
+		void init(i32 max_elements = -1, u8 alloc_flags = VirtualAllocFlags::None)
 		{
 			if (max_elements == -1)
 			{
@@ -52,7 +96,16 @@ namespace forge
 				m_map_size = max_elements * sizeof(Header);
 			}
 
-			m_memory = m_allocator.allocate_bytes(m_map_size);
+			m_memory = m_allocator.reserve_bytes(m_map_size, alloc_flags);
+			m_occupancy = (u64*)m_allocator.reserve_bytes(get_occupancy_word_count(m_map_size / sizeof(Header)) * sizeof(u64));
+
+			if constexpr (IS_SPLIT)
+			{
+				m_metadata = (Metadata*)m_allocator.reserve_bytes(m_map_size / sizeof(Header) * sizeof(Metadata));
+			}
+
+			m_alloc_flags = alloc_flags;
+			m_committed_slots = 0;
 
 			m_offset = 0;
 			m_length = 0;
@@ -63,11 +116,20 @@ namespace forge
 			m_offset = 0;
 			m_length = 0;
 			m_map_size = 0;
+			m_committed_slots = 0;
 
 			if (m_memory)
 			{
 				m_allocator.deallocate_bytes(m_memory, m_map_size);
+				m_allocator.deallocate_bytes((u8*)m_occupancy, 0);
 				m_memory = nullptr;
+				m_occupancy = nullptr;
+
+				if constexpr (IS_SPLIT)
+				{
+					m_allocator.deallocate_bytes((u8*)m_metadata, 0);
+					m_metadata = nullptr;
+				}
 			}
 		}
 
@@ -78,12 +140,12 @@ namespace forge
 
 		Iterator begin() const
 		{
-			return m_memory;
+			return {this, find_next_occupied(0)};
 		}
 
 		Iterator end() const
 		{
-			return m_memory + m_offset;
+			return {this, get_slot_count()};
 		}
 
 		template<class ...Args>
@@ -107,23 +169,17 @@ namespace forge
 
 			constexpr auto header_size = sizeof(Header);
 
-			Header *header;
+			u32 index;
 
-			if (m_free_head)
+			if (m_free_head != NO_SLOT)
 			{
-				header = (Header*)(m_memory + m_free_head->offset);
+				index = m_free_head;
 
-				m_free_head->is_free = false;
+				auto &metadata = get_metadata(index);
 
-				if (m_free_head->next_free != UINT32_MAX)
-				{
-					auto *next_header = (Header*)(m_memory + m_free_head->next_free);
-					m_free_head = next_header;
-				}
-				else
-				{
-					m_free_head = nullptr;
-				}
+				metadata.is_free = false;
+
+				m_free_head = metadata.next_free;
 
 				result.reused = true;
 			}
@@ -131,21 +187,27 @@ namespace forge
 			{
 				assert(m_offset + header_size <= m_map_size && "VirtualArray size exceeded limit");
 
-				header = (Header*)(m_memory + m_offset);
+				index = get_slot_count();
 
-				*header =
+				if (index >= m_committed_slots)
+				{
+					commit_slots(index + 1);
+				}
+
+				get_metadata(index) =
 				{
 					.is_free = false,
-					.next_free = UINT32_MAX,
-					.offset = m_offset,
+					.next_free = NO_SLOT,
 				};
 
 				m_offset += header_size;
 			}
 
+			m_occupancy[index / 64] |= u64{1} << (index % 64);
+
 			m_length++;
 
-			result.ptr = (T*)header->memory;
+			result.ptr = (T*)((Header*)m_memory)[index].memory;
 
 			return result;
 		}
@@ -157,24 +219,30 @@ namespace forge
 				memory->~T();
 			}
 
-			auto *header = get_header(memory);
+			const auto index = get_index_of_mem(memory);
+
+			auto &metadata = get_metadata(index);
 
-			if (header->is_free)
+			if (metadata.is_free)
 			{
 				return;
 			}
 
-			header->is_free = true;
+			metadata.is_free = true;
+			// can still point at whatever followed it the last time it was in the free list
+			metadata.next_free = NO_SLOT;
+
+			m_occupancy[index / 64] &= ~(u64{1} << (index % 64));
 
-			if (m_free_head == nullptr)
+			if (m_free_head == NO_SLOT)
 			{
-				m_free_head = header;
-				m_free_tail = header;
+				m_free_head = index;
+				m_free_tail = index;
 			}
 			else
 			{
-				m_free_tail->next_free = header->offset;
-				m_free_tail = header;
+				get_metadata(m_free_tail).next_free = index;
+				m_free_tail = index;
 			}
 
 			m_length--;
@@ -190,11 +258,21 @@ namespace forge
 				}
 			}
 
+			if (m_occupancy)
+			{
+				memset(m_occupancy, 0, get_occupancy_word_count(get_slot_count()) * sizeof(u64));
+			}
+
+			if (m_committed_slots * sizeof(Header) >= VIRTUAL_ARRAY_DECOMMIT_THRESHOLD)
+			{
+				decommit_slots();
+			}
+
 			m_offset = 0;
 			m_length = 0;
 
-			m_free_head = nullptr;
-			m_free_tail = nullptr;
+			m_free_head = NO_SLOT;
+			m_free_tail = NO_SLOT;
 		}
 
 		// will retrieve an element by index. if index has already been freed will return nullptr
@@ -213,26 +291,30 @@ namespace forge
 			return get_from_offset(offset);
 		}
 
-		inline T* get_from_offset(size_t offset)
+		// the element stored in the header at index, even if it has been freed. index has to be below the slot count
+		inline T* get_slot(u32 index) const
 		{
-			auto *header = (Header*)(m_memory + offset);
+			return (T*)((Header*)m_memory)[index].memory;
+		}
 
-			if (header->is_free)
+		inline T* get_from_offset(size_t offset) const
+		{
+			if (get_metadata(offset / sizeof(Header)).is_free)
 			{
 				return nullptr;
 			}
 
-			return (T*)header->memory;
+			return (T*)(m_memory + offset);
 		}
 
 		inline bool is_free(T *mem) const
 		{
-			return get_header(mem)->is_free;
+			return get_metadata(get_index_of_mem(mem)).is_free;
 		}
 
 		inline u32 get_offset_of_mem(T *mem) const
 		{
-			return get_header(mem)->offset;
+			return (u8*)mem - m_memory;
 		}
 
 		inline u32 get_index_of_mem(T *mem) const
@@ -250,6 +332,41 @@ namespace forge
 			return m_offset;
 		}
 
+		// the amount of headers below the highest one ever allocated, free ones included
+		inline u32 get_slot_count() const
+		{
+			return m_offset / sizeof(Header);
+		}
+
+		// the index of the first live element at or after index, or the slot count if there is none
+		u32 find_next_occupied(u32 index) const
+		{
+			const auto slot_count = get_slot_count();
+
+			if (index >= slot_count)
+			{
+				return slot_count;
+			}
+
+			const auto word_count = get_occupancy_word_count(slot_count);
+
+			auto word = index / 64;
+			auto bits = m_occupancy[word] & (~u64{0} << (index % 64));
+
+			// bits past the slot count are never set, so only the word count has to be checked
+			while (bits == 0)
+			{
+				if (++word >= word_count)
+				{
+					return slot_count;
+				}
+
+				bits = m_occupancy[word];
+			}
+
+			return word * 64 + std::countr_zero(bits);
+		}
+
 		inline size_t get_memory_limits() const
 		{
 			return m_map_size;
@@ -262,23 +379,91 @@ namespace forge
 
 	private:
 		u8 *m_memory = nullptr;
+		// one bit per header, set while it holds a live element. lets iteration jump over free headers
+		// 64 at a time instead of touching each of them
+		u64 *m_occupancy = nullptr;
+		// only used by the split layout, one entry per header
+		Metadata *m_metadata = nullptr;
 		u32 m_offset = 0;
 		u32 m_length = 0;
 		u32 m_map_size = 0;
+		// headers below this are backed by usable memory, as are their metadata and occupancy bits
+		u32 m_committed_slots = 0;
+		u8 m_alloc_flags = VirtualAllocFlags::None;
 		Allocator m_allocator;
 
-		// the start of the first free VirtualArray header
-		Header *m_free_head = nullptr;
-		Header *m_free_tail = nullptr;
+		// indices of the first and last free VirtualArray header
+		u32 m_free_head = NO_SLOT;
+		u32 m_free_tail = NO_SLOT;
+
+		inline Metadata& get_metadata(u32 index) const
+		{
+			if constexpr (IS_SPLIT)
+			{
+				return m_metadata[index];
+			}
+			else
+			{
+				return ((Header*)m_memory)[index].metadata;
+			}
+		}
+
+		// makes the memory for at least slot_count headers usable
+		void commit_slots(u32 slot_count)
+		{
+			const auto max_slots = m_map_size / (u32)sizeof(Header);
+			const auto committed = std::min<u32>(align_to(slot_count * sizeof(Header), get_commit_granularity()) / sizeof(Header), max_slots);
+
+			auto is_committed = m_allocator.commit_bytes(m_memory + m_committed_slots * sizeof(Header),
+				(committed - m_committed_slots) * sizeof(Header), m_alloc_flags);
+
+			const auto first_word = m_committed_slots / 64;
+
+			is_committed &= m_allocator.commit_bytes((u8*)(m_occupancy + first_word),
+				(get_occupancy_word_count(committed) - first_word) * sizeof(u64));
+
+			if constexpr (IS_SPLIT)
+			{
+				is_committed &= m_allocator.commit_bytes((u8*)(m_metadata + m_committed_slots),
+					(committed - m_committed_slots) * sizeof(Metadata));
+			}
+
+			assert(is_committed && "VirtualArray failed to commit memory");
+
+			m_committed_slots = committed;
+		}
+
+		inline size_t get_commit_granularity() const
+		{
+			return m_alloc_flags & VirtualAllocFlags::HugePages ? VIRTUAL_ARRAY_HUGE_PAGE_COMMIT_GRANULARITY : VIRTUAL_ARRAY_COMMIT_GRANULARITY;
+		}
+
+		// gives everything back to the os, the pages come back zeroed once they get committed again
+		void decommit_slots()
+		{
+			// committing rounds the last header out to a whole page, so that page goes as well. leaving it committed
+			// would keep a huge page split up
+			const auto elements_end = align_to((size_t)(m_memory + m_committed_slots * sizeof(Header)), get_page_size());
+
+			m_allocator.decommit_bytes(m_memory, elements_end - (size_t)m_memory);
+			m_allocator.decommit_bytes((u8*)m_occupancy, get_occupancy_word_count(m_committed_slots) * sizeof(u64));
+
+			if constexpr (IS_SPLIT)
+			{
+				m_allocator.decommit_bytes((u8*)m_metadata, m_committed_slots * sizeof(Metadata));
+			}
+
+			m_committed_slots = 0;
+		}
 
-		Header* get_header(T *mem)
+		static constexpr u32 get_occupancy_word_count(u32 slot_count)
 		{
-			return (Header*)((u8*)mem - offsetof(Header, memory));
+			return (slot_count + 63) / 64;
 		}
 	};
 
-	template<class T, class Allocator>
-	class VirtualArray<T, Allocator>::Iterator
+	template<class T, class Allocator, VirtualArrayLayout Layout>
+	class VirtualArray<T, Allocator, Layout>::Iterator
 	{
 	public:
 		using value_type = T;
@@ -287,41 +472,35 @@ namespace forge
 		using reference = T&;
 		using iterator_category = std::forward_iterator_tag;
 
-		Iterator(u8 *memory) :
-			m_memory(memory)
+		Iterator(const VirtualArray *array, u32 index) :
+			m_array(array),
+			m_index(index)
 		{}
 
 		reference operator*()
 		{
-			return *(pointer)((Header*)m_memory)->memory;
+			return *(pointer)((Header*)(m_array->m_memory + m_index * sizeof(Header)))->memory;
 		}
 
 		Iterator& operator++()
 		{
-			Header *header;
-
-			do
-			{
-				m_memory += sizeof(Header);
-
-				header = (Header*)m_memory;
-
-			} while (header->is_free);
+			m_index = m_array->find_next_occupied(m_index + 1);
 
 			return *this;
 		}
 
 		bool operator==(const Iterator &other) const
 		{
-			return m_memory == other.m_memory;
+			return m_index == other.m_index;
 		}
 
 		bool operator!=(const Iterator &other) const
 		{
-			return m_memory != other.m_memory;
+			return m_index != other.m_index;
 		}
 
 	private:
-		u8 *m_memory;
+		const VirtualArray *m_array;
+		u32 m_index;
 	};
 }
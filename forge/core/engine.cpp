@@ -6,6 +6,7 @@
 #include <thread>
 
 #include "logging.hpp"
+#include "forge/concurrency/job_system.hpp"
 #include "forge/editor/editor_subsystem.hpp"
 #include "forge/system/window_sub_system.hpp"
 #include "forge/graphics/ogl_renderer/ogl_renderer.hpp"
@@ -23,6 +24,8 @@ forge::Engine::Engine()
 	// to avoid smart pointers all together
 	m_subsystems.reserve(64);
 
+	// added first so that it is initialized before and shut down after everything that submits jobs
+	add_subsystem<JobSystem>();
 	add_subsystem<OglRenderer>();
 	add_subsystem<WindowSubSystem>();
 	add_subsystem<EditorSubsystem>();
@@ -183,6 +186,8 @@ void forge::Engine::run()
 
 	while (m_should_run)
 	{
+		reset_frame_arenas();
+
 		auto current_time = get_engine_runtime();
 
 		m_delta_time = current_time - m_previous_time;
@@ -220,6 +225,30 @@ void forge::Engine::shutdown()
 	}
 }
 
+forge::FrameArena* forge::Engine::create_frame_arena()
+{
+	auto arena = std::make_unique<FrameArena>();
+
+	if (!arena->init())
+	{
+		log::fatal("failed to reserve {} bytes for a frame arena", FRAME_ARENA_SIZE);
+	}
+
+	std::scoped_lock lock(m_frame_arena_mutex);
+
+	return m_frame_arenas.emplace_back(std::move(arena)).get();
+}
+
+void forge::Engine::reset_frame_arenas()
+{
+	std::scoped_lock lock(m_frame_arena_mutex);
+
+	for (auto &arena : m_frame_arenas)
+	{
+		arena->reset();
+	}
+}
+
 float forge::Engine::get_engine_runtime()
 {
 	return get_subsystem<WindowSubSystem>()->get_runtime();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 #include <span>
@@ -10,6 +11,7 @@
 #include "forge/core/isub_system.hpp"
 #include "forge/system/window.hpp"
 #include "forge/container/map.hpp"
+#include "forge/memory/frame_arena.hpp"
 
 namespace forge
 {
@@ -91,6 +93,9 @@ namespace forge
 			return (T*)iter->second;
 		}
 
+		// gives the calling thread its own frame arena, use get_frame_arena instead of calling this directly
+		FrameArena* create_frame_arena();
+
 		template<class T>
 		inline bool is_subsystem_initialized() const
 		{
@@ -118,6 +123,12 @@ namespace forge
 		// subsystem storage for lookups. allows users to find subsystems by registered type.
 		HashMap<std::type_index, ISubSystem*> m_subsystem_table;
 
+		// one per thread that allocated frame memory, all of them are reset before every frame
+		std::vector<std::unique_ptr<FrameArena>> m_frame_arenas;
+		std::mutex m_frame_arena_mutex;
+
+		void reset_frame_arenas();
+
 		void init_logger(const EngineInitOptions &options);
 
 		EngineInitResult initialize_subsystem(std::set<std::type_index> &initialized_subsystems,
@@ -0,0 +1,360 @@
+#include "archetype.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ecs.hpp"
+#include "forge/memory/mem_utils.hpp"
+
+forge::Archetype::Archetype(Array<ArchetypeComponentInfo> &&components) :
+	m_components(std::move(components))
+{
+	compute_layout();
+}
+
+forge::Archetype::~Archetype()
+{
+	clear();
+}
+
+i32 forge::Archetype::find_column(std::type_index type) const
+{
+	for (u32 i = 0; i < m_components.size(); i++)
+	{
+		if (m_components[i].type == type)
+		{
+			return (i32)i;
+		}
+	}
+
+	return -1;
+}
+
+u32 forge::Archetype::push(Entity *entity)
+{
+	if (m_length == m_chunks.size() * m_chunk_capacity)
+	{
+		auto *memory = (u8*)::operator new(ARCHETYPE_CHUNK_SIZE, std::align_val_t{ARCHETYPE_CHUNK_ALIGNMENT});
+
+		m_chunks.push_back({memory, 0});
+	}
+
+	auto row = m_length++;
+
+	auto &chunk = m_chunks[row / m_chunk_capacity];
+
+	get_entities(chunk)[chunk.count++] = entity;
+
+	return row;
+}
+
+forge::Entity* forge::Archetype::swap_remove(u32 row, bool destroy)
+{
+	assert(row < m_length && "archetype row out of bounds");
+
+	const auto last = m_length - 1;
+
+	if (destroy)
+	{
+		for (u32 column = 0; column < m_components.size(); column++)
+		{
+			m_components[column].destroy(get(column, row));
+		}
+	}
+
+	Entity *moved = nullptr;
+
+	if (row != last)
+	{
+		for (u32 column = 0; column < m_components.size(); column++)
+		{
+			m_components[column].relocate(get(column, row), get(column, last));
+		}
+
+		auto &chunk = m_chunks[row / m_chunk_capacity];
+
+		moved = get_entity(last);
+
+		get_entities(chunk)[row % m_chunk_capacity] = moved;
+	}
+
+	auto &last_chunk = m_chunks.back();
+
+	last_chunk.count--;
+	m_length--;
+
+	// give the memory back once the trailing chunk is empty
+	if (last_chunk.count == 0)
+	{
+		::operator delete(last_chunk.memory, std::align_val_t{ARCHETYPE_CHUNK_ALIGNMENT});
+		m_chunks.pop_back();
+	}
+
+	return moved;
+}
+
+void forge::Archetype::clear()
+{
+	for (auto &chunk : m_chunks)
+	{
+		for (u32 column = 0; column < m_components.size(); column++)
+		{
+			auto *data = get_column_data(chunk, column);
+			auto size = m_components[column].size;
+
+			for (u32 i = 0; i < chunk.count; i++)
+			{
+				m_components[column].destroy(data + i * size);
+			}
+		}
+
+		::operator delete(chunk.memory, std::align_val_t{ARCHETYPE_CHUNK_ALIGNMENT});
+	}
+
+	m_chunks.clear();
+	m_length = 0;
+}
+
+void forge::Archetype::compute_layout()
+{
+	m_column_offsets.resize(m_components.size());
+
+	if (m_components.empty())
+	{
+		return;
+	}
+
+	u32 row_size = sizeof(Entity*);
+
+	for (const auto &component : m_components)
+	{
+		row_size += component.size;
+	}
+
+	// start from the best case and shrink until the alignment padding between columns fits inside the chunk
+	for (m_chunk_capacity = ARCHETYPE_CHUNK_SIZE / row_size; m_chunk_capacity > 0; m_chunk_capacity--)
+	{
+		size_t offset = 0;
+
+		m_entity_column_offset = offset;
+		offset += m_chunk_capacity * sizeof(Entity*);
+
+		for (u32 column = 0; column < m_components.size(); column++)
+		{
+			const auto &component = m_components[column];
+
+			offset = align_to(offset, std::max<size_t>(component.alignment, 1));
+
+			m_column_offsets[column] = offset;
+
+			offset += m_chunk_capacity * component.size;
+		}
+
+		if (offset <= ARCHETYPE_CHUNK_SIZE)
+		{
+			break;
+		}
+	}
+
+	assert(m_chunk_capacity > 0 && "archetype components do not fit inside a single chunk");
+}
+
+forge::ArchetypeStorage::ArchetypeStorage()
+{
+	m_root = m_archetypes.emplace_back(std::make_unique<Archetype>(Array<ArchetypeComponentInfo>{})).get();
+}
+
+u8* forge::ArchetypeStorage::add(Entity *entity, ArchetypeLocation &location, const ArchetypeComponentInfo &info)
+{
+	auto *source = location.archetype ? location.archetype : m_root;
+
+	if (source->has(info.type))
+	{
+		return nullptr;
+	}
+
+	auto *target = get_add_edge(source, info);
+
+	move_entity(entity, location, target);
+
+	auto *ptr = target->get(target->find_column(info.type), location.row);
+
+	info.construct(ptr);
+
+	return ptr;
+}
+
+void forge::ArchetypeStorage::remove(ArchetypeLocation &location, std::type_index type)
+{
+	auto *source = location.archetype;
+
+	if (source == nullptr || !source->has(type))
+	{
+		return;
+	}
+
+	auto *target = get_remove_edge(source, type);
+
+	move_entity(source->get_entity(location.row), location, target);
+}
+
+void forge::ArchetypeStorage::remove_all(ArchetypeLocation &location)
+{
+	if (location.archetype == nullptr)
+	{
+		return;
+	}
+
+	auto *moved = location.archetype->swap_remove(location.row, true);
+
+	if (moved)
+	{
+		moved->m_archetype_location.row = location.row;
+	}
+
+	location = {};
+}
+
+u8* forge::ArchetypeStorage::get(const ArchetypeLocation &location, std::type_index type) const
+{
+	if (location.archetype == nullptr)
+	{
+		return nullptr;
+	}
+
+	auto column = location.archetype->find_column(type);
+
+	if (column == -1)
+	{
+		return nullptr;
+	}
+
+	return location.archetype->get(column, location.row);
+}
+
+void forge::ArchetypeStorage::clear()
+{
+	for (auto &archetype : m_archetypes)
+	{
+		archetype->clear();
+	}
+}
+
+forge::Archetype* forge::ArchetypeStorage::find_or_create(Array<ArchetypeComponentInfo> &&components)
+{
+	std::sort(components.begin(), components.end(), [](const auto &l, const auto &r)
+	{
+		return l.type < r.type;
+	});
+
+	// archetypes are only created when an edge has not been cached yet so a linear search here is fine
+	for (auto &archetype : m_archetypes)
+	{
+		auto &other = archetype->m_components;
+
+		if (other.size() != components.size())
+		{
+			continue;
+		}
+
+		auto equal = std::equal(other.begin(), other.end(), components.begin(), [](const auto &l, const auto &r)
+		{
+			return l.type == r.type;
+		});
+
+		if (equal)
+		{
+			return archetype.get();
+		}
+	}
+
+	return m_archetypes.emplace_back(std::make_unique<Archetype>(std::move(components))).get();
+}
+
+forge::Archetype* forge::ArchetypeStorage::get_add_edge(Archetype *archetype, const ArchetypeComponentInfo &info)
+{
+	auto iter = archetype->m_add_edges.find(info.type);
+
+	if (iter != archetype->m_add_edges.end())
+	{
+		return iter->second;
+	}
+
+	auto components = archetype->m_components;
+
+	components.push_back(info);
+
+	auto *target = find_or_create(std::move(components));
+
+	archetype->m_add_edges.emplace(info.type, target);
+	target->m_remove_edges.emplace(info.type, archetype);
+
+	return target;
+}
+
+forge::Archetype* forge::ArchetypeStorage::get_remove_edge(Archetype *archetype, std::type_index type)
+{
+	auto iter = archetype->m_remove_edges.find(type);
+
+	if (iter != archetype->m_remove_edges.end())
+	{
+		return iter->second;
+	}
+
+	Array<ArchetypeComponentInfo> components;
+
+	for (const auto &component : archetype->m_components)
+	{
+		if (component.type != type)
+		{
+			components.push_back(component);
+		}
+	}
+
+	auto *target = components.empty() ? m_root : find_or_create(std::move(components));
+
+	archetype->m_remove_edges.emplace(type, target);
+	target->m_add_edges.emplace(type, archetype);
+
+	return target;
+}
+
+void forge::ArchetypeStorage::move_entity(Entity *entity, ArchetypeLocation &location, Archetype *target)
+{
+	auto *source = location.archetype;
+
+	ArchetypeLocation new_location {};
+
+	if (target != m_root)
+	{
+		new_location = {target, target->push(entity)};
+	}
+
+	if (source != nullptr)
+	{
+		for (u32 column = 0; column < source->m_components.size(); column++)
+		{
+			auto &component = source->m_components[column];
+			auto *src = source->get(column, location.row);
+			auto target_column = target->find_column(component.type);
+
+			if (target_column == -1)
+			{
+				component.destroy(src);
+			}
+			else
+			{
+				component.relocate(target->get(target_column, new_location.row), src);
+			}
+		}
+
+		auto *moved = source->swap_remove(location.row, false);
+
+		if (moved)
+		{
+			moved->m_archetype_location.row = location.row;
+		}
+	}
+
+	location = new_location;
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+
+#include "forge/container/array.hpp"
+#include "forge/container/map.hpp"
+#include "forge/memory/defs.hpp"
+#include "forge/util/types.hpp"
+
+// the size of a single block of memory that holds a group of entities sharing the same component set
+#define ARCHETYPE_CHUNK_SIZE KB(16)
+#define ARCHETYPE_CHUNK_ALIGNMENT 64
+
+namespace forge
+{
+	class Entity;
+	class ArchetypeStorage;
+
+	// describes how a plain data component is created, relocated and destroyed inside archetype chunks
+	struct ArchetypeComponentInfo
+	{
+		std::type_index type;
+		u32 size;
+		u32 alignment;
+		void(*construct)(u8*);
+		// move constructs the component into dst and destroys the one at src
+		void(*relocate)(u8 *dst, u8 *src);
+		void(*destroy)(u8*);
+	};
+
+	template<class T>
+	ArchetypeComponentInfo make_archetype_component_info()
+	{
+		return
+		{
+			.type = typeid(T),
+			.size = sizeof(T),
+			.alignment = alignof(T),
+			.construct = [](u8 *mem)
+			{
+				new (mem) T();
+			},
+			.relocate = [](u8 *dst, u8 *src)
+			{
+				new (dst) T(std::move(*(T*)src));
+				((T*)src)->~T();
+			},
+			.destroy = [](u8 *mem)
+			{
+				((T*)mem)->~T();
+			},
+		};
+	}
+
+	struct ArchetypeChunk
+	{
+		u8 *memory = nullptr;
+		u32 count = 0;
+	};
+
+	class Archetype;
+
+	// where an entities archetype components are currently stored
+	struct ArchetypeLocation
+	{
+		Archetype *archetype = nullptr;
+		u32 row = 0;
+	};
+
+	// a set of entities that share the exact same archetype components.
+	// every component type gets its own array inside of each chunk so iterating a component type is linear
+	class Archetype
+	{
+	public:
+		explicit Archetype(Array<ArchetypeComponentInfo> &&components);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		// returns the column of the component type or -1 if this archetype does not store it
+		[[nodiscard]]
+		i32 find_column(std::type_index type) const;
+
+		[[nodiscard]]
+		inline bool has(std::type_index type) const
+		{
+			return find_column(type) != -1;
+		}
+
+		template<class ...Ts>
+		[[nodiscard]]
+		inline bool has_all() const
+		{
+			return (has(typeid(Ts)) && ...);
+		}
+
+		[[nodiscard]]
+		inline u8* get(u32 column, u32 row)
+		{
+			auto &chunk = m_chunks[row / m_chunk_capacity];
+
+			return get_column_data(chunk, column) + (row % m_chunk_capacity) * m_components[column].size;
+		}
+
+		[[nodiscard]]
+		inline u8* get_column_data(const ArchetypeChunk &chunk, u32 column) const
+		{
+			return chunk.memory + m_column_offsets[column];
+		}
+
+		template<class T>
+		[[nodiscard]]
+		inline T* get_column_data(const ArchetypeChunk &chunk, u32 column) const
+		{
+			return (T*)get_column_data(chunk, column);
+		}
+
+		[[nodiscard]]
+		inline Entity** get_entities(const ArchetypeChunk &chunk) const
+		{
+			return (Entity**)(chunk.memory + m_entity_column_offset);
+		}
+
+		[[nodiscard]]
+		inline Entity* get_entity(u32 row)
+		{
+			auto &chunk = m_chunks[row / m_chunk_capacity];
+
+			return get_entities(chunk)[row % m_chunk_capacity];
+		}
+
+		[[nodiscard]]
+		inline const Array<ArchetypeComponentInfo>& get_components() const
+		{
+			return m_components;
+		}
+
+		[[nodiscard]]
+		inline const Array<ArchetypeChunk>& get_chunks() const
+		{
+			return m_chunks;
+		}
+
+		[[nodiscard]]
+		inline u32 get_chunk_capacity() const
+		{
+			return m_chunk_capacity;
+		}
+
+		[[nodiscard]]
+		inline u32 get_length() const
+		{
+			return m_length;
+		}
+
+	private:
+		friend ArchetypeStorage;
+
+		// sorted by type so two archetypes with the same component set always compare equal
+		Array<ArchetypeComponentInfo> m_components;
+		// byte offset of every component array from the start of a chunk
+		Array<u32> m_column_offsets;
+		u32 m_entity_column_offset = 0;
+		u32 m_chunk_capacity = 0;
+		u32 m_length = 0;
+		Array<ArchetypeChunk> m_chunks;
+
+		// cached transitions to the archetype with one component type added or removed
+		HashMap<std::type_index, Archetype*> m_add_edges;
+		HashMap<std::type_index, Archetype*> m_remove_edges;
+
+		// appends a row for the entity and returns its index. the component data is left unconstructed
+		u32 push(Entity *entity);
+
+		// removes a row by moving the last row into its place.
+		// returns the entity that now lives at the removed row or nullptr if the last row was removed
+		Entity* swap_remove(u32 row, bool destroy = true);
+
+		void clear();
+
+		void compute_layout();
+	};
+
+	// opt in storage backend for plain data components.
+	// entities that have the same set of data components share fixed size chunks laid out as one array per component
+	// which makes iterating over multiple component types linear instead of a lookup per entity.
+	// pointers to components stored here are invalidated when a data component is added to or removed from
+	// an entity, or when another entity in the same archetype is removed
+	class ArchetypeStorage
+	{
+	public:
+		ArchetypeStorage();
+
+		u8* add(Entity *entity, ArchetypeLocation &location, const ArchetypeComponentInfo &info);
+
+		template<class T>
+		inline T* add(Entity *entity, ArchetypeLocation &location)
+		{
+			static const auto info = make_archetype_component_info<T>();
+
+			return (T*)add(entity, location, info);
+		}
+
+		void remove(ArchetypeLocation &location, std::type_index type);
+
+		// removes all data components owned by the entity at this location
+		void remove_all(ArchetypeLocation &location);
+
+		[[nodiscard]]
+		u8* get(const ArchetypeLocation &location, std::type_index type) const;
+
+		template<class T>
+		[[nodiscard]]
+		inline T* get(const ArchetypeLocation &location) const
+		{
+			return (T*)get(location, typeid(T));
+		}
+
+		// calls fn(Entity&, Ts&...) for every entity that has all of the listed data components
+		template<class ...Ts, class Fn>
+		void each(Fn &&fn)
+		{
+			for (auto &archetype : m_archetypes)
+			{
+				if (archetype->get_length() == 0 || !archetype->template has_all<Ts...>())
+				{
+					continue;
+				}
+
+				std::array<u32, sizeof...(Ts)> columns { (u32)archetype->find_column(typeid(Ts))... };
+
+				for (const auto &chunk : archetype->get_chunks())
+				{
+					auto **entities = archetype->get_entities(chunk);
+
+					each_in_chunk<Ts...>(*archetype, chunk, entities, columns, fn, std::index_sequence_for<Ts...>{});
+				}
+			}
+		}
+
+		void clear();
+
+		[[nodiscard]]
+		inline const Array<std::unique_ptr<Archetype>>& get_archetypes() const
+		{
+			return m_archetypes;
+		}
+
+	private:
+		Array<std::unique_ptr<Archetype>> m_archetypes;
+
+		// the archetype every entity starts in. it has no components and never stores rows
+		Archetype *m_root;
+
+		Archetype* find_or_create(Array<ArchetypeComponentInfo> &&components);
+
+		Archetype* get_add_edge(Archetype *archetype, const ArchetypeComponentInfo &info);
+
+		Archetype* get_remove_edge(Archetype *archetype, std::type_index type);
+
+		// moves the entities row at location into the target archetype and updates location
+		void move_entity(Entity *entity, ArchetypeLocation &location, Archetype *target);
+
+		template<class ...Ts, class Fn, size_t ...I>
+		static void each_in_chunk(Archetype &archetype, const ArchetypeChunk &chunk, Entity **entities,
+			const std::array<u32, sizeof...(Ts)> &columns, Fn &fn, std::index_sequence<I...>)
+		{
+			auto arrays = std::make_tuple(archetype.get_column_data<Ts>(chunk, columns[I])...);
+
+			for (u32 i = 0; i < chunk.count; i++)
+			{
+				fn(*entities[i], std::get<I>(arrays)[i]...);
+			}
+		}
+	};
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+// the highest amount of component types that can be registered across all nexus instances
+#define ECS_MAX_COMPONENT_TYPES 128
+
+namespace forge
+{
+	using ComponentID = u32;
+
+	// handed out instead of an id once ECS_MAX_COMPONENT_TYPES types exist. never set in a signature
+	constexpr ComponentID INVALID_COMPONENT_ID = UINT32_MAX;
+
+	// one bit per component type, set if the entity holds a component of that type
+	struct ComponentSignature
+	{
+		static constexpr u32 WORD_COUNT = ECS_MAX_COMPONENT_TYPES / 64;
+
+		std::array<u64, WORD_COUNT> words {};
+
+		inline void set(ComponentID id)
+		{
+			words[id / 64] |= u64{1} << (id % 64);
+		}
+
+		inline void reset(ComponentID id)
+		{
+			words[id / 64] &= ~(u64{1} << (id % 64));
+		}
+
+		[[nodiscard]]
+		inline bool test(ComponentID id) const
+		{
+			return id < ECS_MAX_COMPONENT_TYPES && (words[id / 64] >> (id % 64)) & 1;
+		}
+
+		// true if every bit set in other is also set in this signature
+		[[nodiscard]]
+		inline bool contains(const ComponentSignature &other) const
+		{
+			u64 missing = 0;
+
+			for (u32 i = 0; i < WORD_COUNT; i++)
+			{
+				missing |= other.words[i] & ~words[i];
+			}
+
+			return missing == 0;
+		}
+
+		// the amount of bits set below id. entities store their components in id order so this is the index of a component
+		[[nodiscard]]
+		inline u32 rank(ComponentID id) const
+		{
+			const auto word = id / 64;
+
+			u32 count = std::popcount(words[word] & ((u64{1} << (id % 64)) - 1));
+
+			for (u32 i = 0; i < word; i++)
+			{
+				count += std::popcount(words[i]);
+			}
+
+			return count;
+		}
+
+		[[nodiscard]]
+		inline u32 count() const
+		{
+			u32 count = 0;
+
+			for (auto word : words)
+			{
+				count += std::popcount(word);
+			}
+
+			return count;
+		}
+
+		// calls fn(id) for every set bit in ascending order
+		template<class Fn>
+		inline void for_each(Fn &&fn) const
+		{
+			for (u32 i = 0; i < WORD_COUNT; i++)
+			{
+				for (auto bits = words[i]; bits != 0; bits &= bits - 1)
+				{
+					fn(ComponentID(i * 64 + std::countr_zero(bits)));
+				}
+			}
+		}
+
+		bool operator==(const ComponentSignature &other) const = default;
+	};
+}
@@ -1,6 +1,26 @@
 #pragma once
 
+#include <cstdint>
+
 namespace forge
 {
 	using DeltaTime = f32;
-}
\ No newline at end of file
+
+	// refers to an entity through the slot table of its nexus instead of its memory. once the entity is destroyed the
+	// slot generation moves on, so a stale handle resolves to nullptr even after the memory got reused
+	struct EntityHandle
+	{
+		static constexpr u32 NULL_INDEX = UINT32_MAX;
+
+		u32 index = NULL_INDEX;
+		u32 generation = 0;
+
+		[[nodiscard]]
+		inline bool is_null() const
+		{
+			return index == NULL_INDEX;
+		}
+
+		bool operator==(const EntityHandle &other) const = default;
+	};
+}
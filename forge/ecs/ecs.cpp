@@ -1,9 +1,13 @@
 #include "ecs.hpp"
 
+#include <algorithm>
 #include <mutex>
+#include <numeric>
 #include <sys/mman.h>
 
+#include "forge/concurrency/job_system.hpp"
 #include "forge/core/engine.hpp"
+#include "forge/memory/mem_utils.hpp"
 
 void forge::IComponent::set_enabled(bool value)
 {
@@ -19,8 +23,70 @@ void forge::IComponent::set_enabled(bool value)
 	}
 }
 
+namespace
+{
+	struct ComponentIdRegistry
+	{
+		std::mutex mutex;
+		forge::HashMap<std::type_index, forge::ComponentID> ids;
+		// reserved up front so handing out an id never moves the types, which are read without the lock
+		forge::Array<std::type_index> types;
+
+		ComponentIdRegistry()
+		{
+			types.reserve(ECS_MAX_COMPONENT_TYPES);
+		}
+	};
+
+	ComponentIdRegistry& get_component_id_registry()
+	{
+		static ComponentIdRegistry registry;
+		return registry;
+	}
+}
+
+forge::ComponentID forge::get_component_id(std::type_index type)
+{
+	auto &registry = get_component_id_registry();
+
+	std::scoped_lock lock {registry.mutex};
+
+	if (auto iter = registry.ids.find(type); iter != registry.ids.end())
+	{
+		return iter->second;
+	}
+
+	if (registry.types.size() >= ECS_MAX_COMPONENT_TYPES)
+	{
+		log::fatal("can not hand out an id for {}, raise ECS_MAX_COMPONENT_TYPES", type.name());
+
+		return INVALID_COMPONENT_ID;
+	}
+
+	const auto id = (ComponentID)registry.types.size();
+
+	registry.ids.emplace(type, id);
+	registry.types.push_back(type);
+
+	return id;
+}
+
+std::type_index forge::get_component_type(ComponentID id)
+{
+	// whoever holds the id got it from get_component_id, which stored the type before handing it out
+	return get_component_id_registry().types.data()[id];
+}
+
 forge::TimerID forge::IComponent::add_timer(TimerOptions &&options) const
 {
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+	// the timeout most likely touches this component so stop the timer once the entity is gone
+	if (options.owner.is_null())
+	{
+		options.owner = m_owner->get_handle();
+	}
+
 	return m_owner->get_nexus()->timer.add(std::forward<TimerOptions>(options));
 }
 
@@ -34,7 +100,7 @@ u8* forge::Entity::add_component(std::type_index index)
 	return m_nexus->add_component(this, index);
 }
 
-forge::VirtualArray<forge::Entity> forge::Entity::get_children() const
+const forge::EntityArray& forge::Entity::get_children() const
 {
 	return m_children;
 }
@@ -63,9 +129,9 @@ void forge::Entity::remove_component(std::type_index index)
 
 void forge::Entity::on_editor_enter()
 {
-	for (auto &[_, component] : m_components)
+	for (u32 i = 0; i < m_signature.count(); i++)
 	{
-		component->on_editor_enter();
+		m_components[i]->on_editor_enter();
 	}
 }
 
@@ -88,15 +154,20 @@ void forge::Entity::destroy()
 
 void forge::Entity::update_dirty_array()
 {
-	std::scoped_lock lock {m_nexus->m_dirty_table_mutex};
-
-	auto *top_most_parent = get_top_most_parent();
+	// the pass recomputes the whole tree of a queued root anyway
+	if (m_top_most_parent != nullptr && m_top_most_parent->m_is_queued_for_cleaning.load(std::memory_order_relaxed))
+	{
+		return;
+	}
 
-	if (!top_most_parent->m_is_queued_for_cleaning)
+	// plain load first so setting the same entity over and over doesn't keep writing to its cache line
+	if (m_is_queued_for_cleaning.load(std::memory_order_relaxed) ||
+		m_is_queued_for_cleaning.exchange(true, std::memory_order_acq_rel))
 	{
-		m_nexus->m_entity_dirty_table.emplace_back(top_most_parent);
-		top_most_parent->m_is_queued_for_cleaning = true;
+		return;
 	}
+
+	m_nexus->queue_dirty_entity(this);
 }
 
 void forge::Entity::set_parent(Entity *parent)
@@ -105,6 +176,37 @@ void forge::Entity::set_parent(Entity *parent)
 	m_transform.parent = &parent->m_transform;
 }
 
+bool forge::ComponentAccess::conflicts_with(const ComponentAccess &other) const
+{
+	if (!is_declared || !other.is_declared)
+	{
+		return true;
+	}
+
+	auto contains = [](const Array<std::type_index> &types, std::type_index type)
+	{
+		return std::find(types.begin(), types.end(), type) != types.end();
+	};
+
+	for (auto type : writes)
+	{
+		if (contains(other.writes, type) || contains(other.reads, type))
+		{
+			return true;
+		}
+	}
+
+	for (auto type : other.writes)
+	{
+		if (contains(reads, type))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void forge::Nexus::ComponentType::free(IComponent *component)
 {
 	component->on_destroy();
@@ -114,20 +216,55 @@ void forge::Nexus::ComponentType::free(IComponent *component)
 	mem_pool.free(component->m_id);
 }
 
-void forge::Nexus::ComponentType::update(DeltaTime delta) const
+void forge::Nexus::ComponentType::update(DeltaTime delta, JobSystem *job_system) const
 {
-	for (auto &component : mem_pool.get_iterator<IComponent>())
+	// only registered with override_should_update so there is no concrete update to call
+	if (!update_range)
 	{
-		if (component.m_is_valid && component.m_is_enabled) [[likely]]
+		for (auto &component : mem_pool.get_iterator<IComponent>())
 		{
-			component.update(delta);
+			if (component.m_is_valid && component.m_is_enabled) [[likely]]
+			{
+				component.update(delta);
+			}
 		}
+
+		return;
 	}
+
+	// freed slots in between are skipped by update_range
+	const auto length = mem_pool.get_slot_count();
+
+	if (!is_parallel || job_system == nullptr || length < ECS_PARALLEL_UPDATE_MIN_COMPONENTS)
+	{
+		update_range(mem_pool, 0, length, delta);
+		return;
+	}
+
+	// the smallest amount of components that fills whole cache lines. pool memory starts on a cache line, so making
+	// every batch a multiple of it means two threads never write to the same cache line
+	const auto step = ECS_CACHE_LINE_SIZE / std::gcd<size_t>(ECS_CACHE_LINE_SIZE, mem_pool.get_element_size());
+	const auto batch_count = job_system->get_thread_count() * ECS_PARALLEL_UPDATE_CHUNKS_PER_THREAD;
+	const auto batch_size = align_to((length + batch_count - 1) / batch_count, step);
+
+	job_system->parallel_for(length, batch_size, [this, delta](size_t first, size_t last)
+	{
+		// can already be set when this type is updated concurrently with other types
+		const auto was_concurrent = g_is_in_concurrent_update;
+
+		g_is_in_concurrent_update = true;
+		update_range(mem_pool, first, last, delta);
+		g_is_in_concurrent_update = was_concurrent;
+	});
 }
 
 std::string forge::Nexus::init(const EngineInitOptions &options)
 {
-	m_entities.init(ECS_ENTITY_POOL_SIZE);
+	m_entities.init(ECS_ENTITY_POOL_SIZE, ECS_ENTITY_POOL_ALLOC_FLAGS);
+
+	m_job_system = g_engine.get_subsystem<JobSystem>();
+
+	m_dirty_buffers.resize(m_job_system ? m_job_system->get_thread_count() : 0);
 
 	return {};
 }
@@ -145,8 +282,11 @@ void forge::Nexus::shutdown()
 		unregister_component(type_index, false);
 	}
 
+	m_archetypes.clear();
+
 	// call destructors so allocated memory will be freed
-	m_entities.clear();
+	destroy_all_entities(m_entities);
+	m_entities.clear(false);
 }
 
 void forge::Nexus::unregister_component(std::type_index type_index, bool remove_from_update_table)
@@ -162,6 +302,8 @@ void forge::Nexus::unregister_component(std::type_index type_index, bool remove_
 
 	m_component_table.erase(it);
 
+	refresh_component_types();
+
 	if (remove_from_update_table)
 	{
 		// while this is a less than efficient way to remove the component type from the update table i think its
@@ -170,11 +312,15 @@ void forge::Nexus::unregister_component(std::type_index type_index, bool remove_
 		auto index = std::find(m_update_table.begin(), m_update_table.end(), type_index);
 
 		m_update_table.erase(index);
+
+		m_is_update_schedule_dirty = true;
 	}
 }
 
 forge::Entity* forge::Nexus::create_entity(std::string_view name, Entity *parent)
 {
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
 	const auto is_child = parent != nullptr;
 
 	if (is_child && !parent->m_children.is_initialized())
@@ -195,8 +341,25 @@ forge::Entity* forge::Nexus::create_entity(std::string_view name, Entity *parent
 		entity->m_top_most_parent = parent->get_top_most_parent();
 	}
 
+	u32 slot_index;
+
+	if (m_free_entity_slots.empty())
+	{
+		slot_index = m_entity_slots.size();
+		m_entity_slots.emplace_back();
+	}
+	else
+	{
+		slot_index = m_free_entity_slots.back();
+		m_free_entity_slots.pop_back();
+	}
+
+	auto &slot = m_entity_slots[slot_index];
+	slot.entity = entity;
+
 	entity->m_nexus = this;
 	entity->m_id = m_id_counter++;
+	entity->m_handle = {slot_index, slot.generation};
 	entity->m_is_valid = true;
 
 	if (!name.empty())
@@ -219,10 +382,10 @@ void forge::Nexus::add_to_group(std::string_view group_name, Entity *entity)
 
 	if (iter == m_groups.end())
 	{
-		iter = m_groups.emplace(group_name, Array<Entity*>{}).first;
+		iter = m_groups.emplace(group_name, Array<EntityHandle>{}).first;
 	}
 
-	iter->second.emplace_back(entity);
+	iter->second.emplace_back(entity->get_handle());
 }
 
 void forge::Nexus::remove_from_group(std::string_view group_name, Entity *entity)
@@ -234,17 +397,14 @@ void forge::Nexus::remove_from_group(std::string_view group_name, Entity *entity
 		return;
 	}
 
-	auto &entities = iter->second;
+	auto &handles = iter->second;
 
-	for (auto i = 0; i < entities.size(); i++)
-	{
-		auto *other = entities[i];
+	auto handle = std::find(handles.begin(), handles.end(), entity->get_handle());
 
-		if (other->is_valid() && other->get_id() == entity->get_id())
-		{
-			std::swap(entities[i], entities[entities.size()-1]);
-			entities.pop_back();
-		}
+	if (handle != handles.end())
+	{
+		std::swap(*handle, handles.back());
+		handles.pop_back();
 	}
 }
 
@@ -260,10 +420,10 @@ void forge::Nexus::create_group(std::string_view group_name)
 		return;
 	}
 
-	m_groups.emplace(group_name, std::vector<Entity*>{});
+	m_groups.emplace(group_name, Array<EntityHandle>{});
 }
 
-std::vector<forge::Entity*>* forge::Nexus::get_group(std::string_view group_name, bool trim_invalid_entities)
+forge::Array<forge::EntityHandle>* forge::Nexus::get_group(std::string_view group_name)
 {
 	auto iter = m_groups.find(group_name);
 
@@ -272,23 +432,19 @@ std::vector<forge::Entity*>* forge::Nexus::get_group(std::string_view group_name
 		return nullptr;
 	}
 
-	auto &entities = iter->second;
+	return &iter->second;
+}
 
-	if (trim_invalid_entities)
+forge::Entity* forge::Nexus::resolve(EntityHandle handle) const
+{
+	if (handle.index >= m_entity_slots.size())
 	{
-		for (auto i = 0; i < entities.size(); i++)
-		{
-			auto &view = entities[i];
-
-			if (!view->is_valid())
-			{
-				std::swap(entities[i], entities[entities.size()-1]);
-				entities.pop_back();
-			}
-		}
+		return nullptr;
 	}
 
-	return &entities;
+	const auto &slot = m_entity_slots[handle.index];
+
+	return slot.generation == handle.generation ? slot.entity : nullptr;
 }
 
 forge::Entity* forge::Nexus::get_entity(std::string_view name)
@@ -305,12 +461,17 @@ forge::Entity* forge::Nexus::get_entity(std::string_view name)
 
 void forge::Nexus::destroy_entity(Entity *entity)
 {
-	for (auto &[index, component] : entity->m_components)
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+	entity->m_signature.for_each([&](ComponentID id)
 	{
-		m_component_table[index].free(component);
-	}
+		m_component_types[id]->free(entity->m_components[entity->m_signature.rank(id)]);
+	});
 
-	entity->m_components.clear();
+	entity->m_signature = {};
+	entity->m_components = {};
+
+	m_archetypes.remove_all(entity->m_archetype_location);
 
 	for (auto &child : entity->m_children)
 	{
@@ -322,33 +483,61 @@ void forge::Nexus::destroy_entity(Entity *entity)
 		m_name_table.erase(entity->m_name);
 	}
 
+	auto &slot = m_entity_slots[entity->m_handle.index];
+	slot.entity = nullptr;
+	slot.generation++;
+
+	m_free_entity_slots.push_back(entity->m_handle.index);
+
+	// children live in the array of their parent
+	auto &owning_array = entity->m_parent ? entity->m_parent->m_children : m_entities;
+
+	entity->m_handle = {};
+	// the children were freed above. their slots are kept instead of clearing the array so the entities in them
+	// can still be reached by destroy_all_entities
 	entity->m_is_valid = false;
-	entity->m_children.clear(false);
 	entity->m_transform = {};
 	entity->m_name.clear();
 	entity->m_parent = nullptr;
 	entity->m_top_most_parent = nullptr;
 
-	m_entities.free(entity, false);
+	owning_array.free(entity, false);
 }
 
 u8* forge::Nexus::add_component(Entity *entity, std::type_index index)
 {
-	if (entity->m_components.contains(index))
+	auto iter = m_component_table.find(index);
+
+	if (iter == m_component_table.end())
 	{
 		return nullptr;
 	}
 
-	auto &ct = m_component_table[index];
+	return add_component_by_id(entity, iter->second.id);
+}
 
-	auto [ptr, id] = ct.mem_pool.allocate(true);
+u8* forge::Nexus::add_component_by_id(Entity *entity, ComponentID id)
+{
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+	if (entity->m_signature.test(id))
+	{
+		return nullptr;
+	}
+
+	auto [ptr, offset] = m_component_types[id]->mem_pool.allocate(true);
+
+	if (ptr == nullptr)
+	{
+		return nullptr;
+	}
 
 	auto *component = (IComponent*)ptr;
 
 	component->m_owner = entity;
 	component->m_is_valid = true;
 	component->m_is_enabled = true;
-	component->m_id = id;
+	component->m_id = offset;
 
 	for (const auto &index : component->get_bundle())
 	{
@@ -357,37 +546,284 @@ u8* forge::Nexus::add_component(Entity *entity, std::type_index index)
 
 	component->on_create();
 
+	auto register_id = id;
+
 	if (auto reg_index = component->get_register_type(); reg_index != typeid(IComponent))
 	{
-		index = reg_index;
+		register_id = get_component_id(reg_index);
 	}
 
-	entity->m_components[index] = component;
+	if (!insert_component(entity, register_id, component))
+	{
+		m_component_types[id]->free(component);
+		return nullptr;
+	}
 
 	return ptr;
 }
 
+void forge::Nexus::add_component_to_all(std::span<Entity* const> entities, std::type_index index)
+{
+	auto iter = m_component_table.find(index);
+
+	if (iter == m_component_table.end())
+	{
+		return;
+	}
+
+	add_component_to_all_by_id(entities, iter->second.id);
+}
+
+void forge::Nexus::add_component_to_all_by_id(std::span<Entity* const> entities, ComponentID requested_id)
+{
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+	// matches add_component which refuses to add a type the entity already holds and leaves its bundle alone
+	FrameArray<Entity*> targets;
+	targets.reserve(entities.size());
+
+	for (auto *entity : entities)
+	{
+		if (!entity->m_signature.test(requested_id))
+		{
+			targets.push_back(entity);
+		}
+	}
+
+	if (targets.empty())
+	{
+		return;
+	}
+
+	auto &pool = m_component_types[requested_id]->mem_pool;
+
+	const auto stride = pool.get_element_size();
+	auto [memory, _] = pool.allocate((u32)targets.size(), true);
+
+	if (memory == nullptr)
+	{
+		return;
+	}
+	const auto first_index = (memory - pool.get_memory()) / stride;
+
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		auto *component = (IComponent*)(memory + i * stride);
+
+		component->m_owner = targets[i];
+		component->m_is_valid = true;
+		component->m_is_enabled = true;
+		component->m_id = pool.get_offset_of_index(first_index + i);
+	}
+
+	auto *first = (IComponent*)memory;
+
+	// can register new types which moves the component table around, so pool must not be used past this
+	for (const auto &bundled : first->get_bundle())
+	{
+		add_component_to_all(targets, bundled);
+	}
+
+	auto id = requested_id;
+
+	if (auto register_index = first->get_register_type(); register_index != typeid(IComponent))
+	{
+		id = get_component_id(register_index);
+	}
+
+	auto *ct = m_component_types[requested_id];
+
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		auto *component = (IComponent*)(memory + i * stride);
+
+		component->on_create();
+
+		if (!insert_component(targets[i], id, component))
+		{
+			ct->free(component);
+		}
+	}
+}
+
+void forge::Nexus::destroy_entities(std::span<Entity* const> entities)
+{
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+	m_free_entity_slots.reserve(m_free_entity_slots.size() + entities.size());
+
+	for (auto *entity : entities)
+	{
+		destroy_entity(entity);
+	}
+}
+
+bool forge::Nexus::insert_component(Entity *entity, ComponentID id, IComponent *component)
+{
+	// the type it is registered as did not get an id
+	if (id == INVALID_COMPONENT_ID)
+	{
+		return false;
+	}
+
+	const auto rank = entity->m_signature.rank(id);
+
+	// the id might already be taken by a component added through another type
+	if (!entity->m_signature.test(id))
+	{
+		const auto count = entity->m_signature.count();
+
+		if (count >= ECS_MAX_COMPONENTS_PER_ENTITY)
+		{
+			log::fatal("entity {} already holds {} components, raise ECS_MAX_COMPONENTS_PER_ENTITY to add {}",
+				entity->m_id, count, get_component_type(id).name());
+
+			return false;
+		}
+
+		std::copy_backward(&entity->m_components[rank], &entity->m_components[count], &entity->m_components[count + 1]);
+
+		entity->m_signature.set(id);
+	}
+
+	entity->m_components[rank] = component;
+
+	return true;
+}
+
+void forge::Nexus::on_component_relocated(IComponent *previous, IComponent *component)
+{
+	auto *owner = component->m_owner;
+
+	const auto count = owner->m_signature.count();
+
+	for (u32 i = 0; i < count; i++)
+	{
+		if (owner->m_components[i] == previous)
+		{
+			owner->m_components[i] = component;
+			return;
+		}
+	}
+}
+
+void forge::Nexus::compact_component_pools()
+{
+	for (auto &[_, ct] : m_component_table)
+	{
+		if (ct.mem_pool.is_compact() && ct.mem_pool.get_free_count() > 0)
+		{
+			ct.mem_pool.compact();
+		}
+	}
+}
+
 void forge::Nexus::remove_component(Entity *entity, std::type_index index)
 {
-	auto iter = entity->m_components.find(index);
+	auto iter = m_component_table.find(index);
 
-	if (iter == entity->m_components.end())
+	if (iter == m_component_table.end())
 	{
 		return;
 	}
 
-	auto &ct = m_component_table[index];
+	remove_component_by_id(entity, iter->second.id);
+}
+
+void forge::Nexus::remove_component_by_id(Entity *entity, ComponentID id)
+{
+	ASSERT_NOT_IN_CONCURRENT_UPDATE();
 
-	ct.free(iter->second);
+	if (!entity->m_signature.test(id))
+	{
+		return;
+	}
 
-	entity->m_components.erase(iter);
+	const auto rank = entity->m_signature.rank(id);
+	const auto count = entity->m_signature.count();
+
+	m_component_types[id]->free(entity->m_components[rank]);
+
+	std::copy(&entity->m_components[rank + 1], &entity->m_components[count], &entity->m_components[rank]);
+
+	entity->m_components[count - 1] = nullptr;
+	entity->m_signature.reset(id);
+}
+
+void forge::Nexus::refresh_component_types()
+{
+	m_component_types = {};
+
+	for (auto &[_, ct] : m_component_table)
+	{
+		m_component_types[ct.id] = &ct;
+	}
 }
 
 void forge::Nexus::update()
 {
 	auto delta = g_engine.get_delta();
 
-	for (auto &type : m_update_table)
+	if (m_is_update_schedule_dirty)
+	{
+		build_update_schedule();
+	}
+
+	compact_component_pools();
+
+	for (auto &level : m_update_schedule)
+	{
+		if (level.size() == 1 || m_job_system == nullptr)
+		{
+			for (auto type : level)
+			{
+				update_component_type(type, delta);
+			}
+
+			continue;
+		}
+
+		JobCounter counter;
+
+		for (auto type : level)
+		{
+			m_job_system->run(counter, [this, type, delta]
+			{
+				g_is_in_concurrent_update = true;
+				update_component_type(type, delta);
+				g_is_in_concurrent_update = false;
+			});
+		}
+
+		m_job_system->wait(counter);
+	}
+
+	m_deferred_commands.execute_all();
+
+	timer.process(this);
+
+	update_transforms();
+}
+
+void forge::Nexus::build_update_schedule()
+{
+	m_update_schedule.clear();
+	m_is_update_schedule_dirty = false;
+
+	struct Entry
+	{
+		std::type_index type;
+		const ComponentAccess *access;
+		u32 level;
+	};
+
+	Array<Entry> entries;
+	entries.reserve(m_update_table.size());
+
+	// a type is placed one level after the last type before it in the update table that it conflicts with.
+	// this keeps the update order between conflicting types the same as the registration order.
+	// quadratic but the update table is small and only rebuilt when components get registered
+	for (auto type : m_update_table)
 	{
 		auto iter = m_component_table.find(type);
 
@@ -396,26 +832,169 @@ void forge::Nexus::update()
 			continue;
 		}
 
-		iter->second.update(delta);
+		const auto &access = iter->second.access;
+
+		u32 level = 0;
+
+		for (const auto &entry : entries)
+		{
+			if (access.conflicts_with(*entry.access))
+			{
+				level = std::max(level, entry.level + 1);
+			}
+		}
+
+		entries.push_back({type, &access, level});
+
+		if (level >= m_update_schedule.size())
+		{
+			m_update_schedule.resize(level + 1);
+		}
+
+		m_update_schedule[level].push_back(type);
 	}
+}
 
-	timer.process();
+void forge::Nexus::update_transforms()
+{
+	// the buffers are only written to by the update functions, which have all finished by now
+	for (auto &buffer : m_dirty_buffers)
+	{
+		m_processing_dirty_table.insert(m_processing_dirty_table.end(), buffer.entities.begin(), buffer.entities.end());
+		buffer.entities.clear();
+	}
+
+	{
+		std::scoped_lock lock {m_foreign_dirty_mutex};
+
+		m_processing_dirty_table.insert(m_processing_dirty_table.end(), m_foreign_dirty_buffer.begin(), m_foreign_dirty_buffer.end());
+		m_foreign_dirty_buffer.clear();
+	}
+
+	if (m_processing_dirty_table.empty())
+	{
+		return;
+	}
+
+	m_transform_pass.clear();
+	m_transform_pass_ranges.clear();
+
+	for (auto *entity : m_processing_dirty_table)
+	{
+		if (!entity->m_is_valid)
+		{
+			continue;
+		}
+
+		// an ancestor that changed as well already covers this whole subtree
+		auto is_covered = false;
+
+		for (auto *parent = entity->m_parent; parent != nullptr; parent = parent->m_parent)
+		{
+			if (parent->m_is_queued_for_cleaning.load(std::memory_order_relaxed))
+			{
+				is_covered = true;
+				break;
+			}
+		}
+
+		if (!is_covered)
+		{
+			flatten_hierarchy(entity);
+		}
+	}
+
+	// cleared before the signals fire so listeners can mark entities dirty again for the next pass
+	for (auto *entity : m_processing_dirty_table)
+	{
+		entity->m_is_queued_for_cleaning.store(false, std::memory_order_relaxed);
+	}
+
+	m_processing_dirty_table.clear();
+
+	// subtrees don't share any nodes so they can be recomputed independently
+	auto *job_system = m_transform_pass.size() >= ECS_PARALLEL_TRANSFORM_MIN_ENTITIES ? m_job_system : nullptr;
+
+	m_transform_soa.resize(m_transform_pass.size());
+	m_transform_parents.resize(m_transform_pass.size());
+	m_transform_outputs.resize(m_transform_pass.size());
+
+	parallel_for(job_system, m_transform_pass_ranges.size(), 0, [this](size_t first, size_t last)
+	{
+		const auto begin = first == 0 ? 0 : m_transform_pass_ranges[first - 1];
+		const auto end = m_transform_pass_ranges[last - 1];
+
+		for (auto i = begin; i < end; i++)
+		{
+			auto &transform = m_transform_pass[i]->m_transform;
+
+			m_transform_soa.set(i, transform.get_local_position(), transform.get_local_rotation(), transform.get_scale());
+			m_transform_parents[i] = transform.parent ? &transform.parent->get_global_matrix_storage() : nullptr;
+			m_transform_outputs[i] = &transform.get_global_matrix_storage();
+
+			transform.is_dirty = false;
+		}
+
+		// parents always come before their children in the pass, which is the order the kernel writes in
+		compute_global_matrices(m_transform_soa, m_transform_parents.data(), m_transform_outputs.data(), begin, end);
+	});
+
+	// listeners touch things like render objects which are not thread safe
+	for (auto *entity : m_transform_pass)
+	{
+		entity->on_transform_update(*entity);
+	}
+}
+
+void forge::Nexus::queue_dirty_entity(Entity *entity)
+{
+	const auto thread_index = g_job_thread_index;
+
+	if (thread_index < m_dirty_buffers.size())
+	{
+		m_dirty_buffers[thread_index].entities.push_back(entity);
+		return;
+	}
+
+	std::scoped_lock lock {m_foreign_dirty_mutex};
+	m_foreign_dirty_buffer.push_back(entity);
+}
+
+void forge::Nexus::flatten_hierarchy(Entity *root)
+{
+	const auto begin = m_transform_pass.size();
+
+	m_transform_pass.push_back(root);
 
-	if (!m_entity_dirty_table.empty())
+	for (auto i = begin; i < m_transform_pass.size(); i++)
 	{
-		std::scoped_lock lock {m_dirty_table_mutex};
+		auto *entity = m_transform_pass[i];
 
-		for (auto *entity : m_entity_dirty_table)
+		for (auto &child : entity->m_children)
 		{
-			entity->update_hierarchy();
-			entity->m_is_queued_for_cleaning = false;
+			if (child.m_is_valid)
+			{
+				m_transform_pass.push_back(&child);
+			}
 		}
+	}
 
-		m_entity_dirty_table.clear();
+	m_transform_pass_ranges.push_back(m_transform_pass.size());
+}
+
+void forge::Nexus::update_component_type(std::type_index type, DeltaTime delta)
+{
+	auto iter = m_component_table.find(type);
+
+	if (iter == m_component_table.end())
+	{
+		return;
 	}
+
+	iter->second.update(delta, m_job_system);
 }
 
-forge::VirtualArray<forge::Entity> forge::Nexus::get_entities()
+const forge::EntityArray& forge::Nexus::get_entities() const
 {
 	return m_entities;
 }
@@ -436,17 +1015,57 @@ void forge::Nexus::clear()
 		});
 	}
 
-	m_entity_dirty_table.clear();
+	m_archetypes.clear();
+
+	for (auto &buffer : m_dirty_buffers)
+	{
+		buffer.entities.clear();
+	}
+
+	m_foreign_dirty_buffer.clear();
+	m_processing_dirty_table.clear();
 	m_groups.clear();
+
+	// every entity is gone so every slot is free and all handles handed out so far are stale
+	m_free_entity_slots.clear();
+
+	for (u32 i = 0; i < m_entity_slots.size(); i++)
+	{
+		auto &slot = m_entity_slots[i];
+		slot.entity = nullptr;
+		slot.generation++;
+
+		m_free_entity_slots.push_back(i);
+	}
+
 	// m_update_table.clear();
 	m_name_table.clear();
 	// m_component_table.clear();
 
+	// clear can decommit the entity pages, which would drop what the entities own without freeing it
+	destroy_all_entities(m_entities);
 	m_entities.clear(false);
 }
 
+void forge::Nexus::destroy_all_entities(EntityArray &array)
+{
+	for (u32 i = 0; i < array.get_slot_count(); i++)
+	{
+		auto *entity = array.get_slot(i);
+
+		if (entity->m_children.is_initialized())
+		{
+			destroy_all_entities(entity->m_children);
+		}
+
+		entity->~Entity();
+	}
+}
+
 void forge::Nexus::trigger_on_begin()
 {
+	compact_component_pools();
+
 	for (auto &[_, ct] : m_component_table)
 	{
 		for (auto &component : ct.mem_pool.get_iterator<IComponent>())
@@ -1,21 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
 #include <cstdint>
 #include <typeindex>
 #include <concepts>
+#include <mutex>
+#include <span>
 #include <variant>
 #include <tuple>
 
 #include "forge/container/map.hpp"
 #include "forge/fmt/fmt.hpp"
 #include "forge/memory/defs.hpp"
+#include "forge/memory/frame_arena.hpp"
 #include "forge/memory/mem_pool.hpp"
 #include "forge/events/signal.hpp"
 #include "forge/core/isub_system.hpp"
 #include "defs.hpp"
+#include "archetype.hpp"
+#include "component_signature.hpp"
 
 #include "component_field.hpp"
 #include "../math/transform.hpp"
+#include "../math/transform_kernel.hpp"
 #include "forge/util/types.hpp"
 
 // should get included as a part of ecs.hpp. don't remove this.
@@ -23,21 +31,71 @@
 #include "forge/container/array.hpp"
 #include "forge/container/view.hpp"
 #include "forge/container/virtual_array.hpp"
+#include "forge/concurrency/command_buffer.hpp"
 #include "forge/events/timer.hpp"
 #include "forge/util/macros.hpp"
 
 // the maximum amount of virtual memory that will be used for each component by default unless specified otherwise by the component
 #define DEFAULT_ECS_MAX_MAPPED_MEMORY MB(48)
+// component pools are mostly untouched reservations. huge pages are left to components that opt in as every pool
+// would fault in 2MB at once
+#define DEFAULT_ECS_ALLOC_FLAGS forge::VirtualAllocFlags::NoReserve
+// the entity pool is large and swept over every frame
+#define ECS_ENTITY_POOL_ALLOC_FLAGS (forge::VirtualAllocFlags::NoReserve | forge::VirtualAllocFlags::HugePages)
 #define ECS_ENTITY_POOL_SIZE  900'000
 #define ECS_CHILD_LIMIT 32
+// the highest amount of pooled components a single entity can hold. adding more logs a fatal error and returns nullptr
+#define ECS_MAX_COMPONENTS_PER_ENTITY 16
+// components of a PARALLEL_UPDATE type are only split across threads once there are at least this many
+#define ECS_PARALLEL_UPDATE_MIN_COMPONENTS 1024
+// how many chunks each thread gets so threads that finish early can pick up more work
+#define ECS_PARALLEL_UPDATE_CHUNKS_PER_THREAD 4
+#define ECS_CACHE_LINE_SIZE 64
+// the transform pass is only spread over the job system once it has to recompute at least this many entities
+#define ECS_PARALLEL_TRANSFORM_MIN_ENTITIES 2048
+
+#define ASSERT_NOT_IN_CONCURRENT_UPDATE() \
+    assert(!forge::g_is_in_concurrent_update && "structural changes during a concurrent update must go through Nexus::defer")
 
 namespace forge
 {
     class Nexus;
     class Entity;
+    class JobSystem;
+
+    template<class ...Ts>
+    class NexusView;
 
     using EntityID = u32;
 
+    // entities are large and the transform pass sweeps over them, so their free list metadata is kept out of line
+    using EntityArray = VirtualArray<Entity, VirtualAllocator<Entity>, VirtualArrayLayout::Split>;
+
+    // hands out a dense id for a component type. ids are shared by all nexus instances and never reused.
+    // INVALID_COMPONENT_ID once ECS_MAX_COMPONENT_TYPES types have been handed out
+    ComponentID get_component_id(std::type_index type);
+
+    // the type the given id was handed out for. lock free
+    std::type_index get_component_type(ComponentID id);
+
+    template<class T>
+    inline ComponentID component_id_of()
+    {
+        static const auto id = get_component_id(typeid(T));
+
+        return id;
+    }
+
+    template<class ...Ts>
+    inline ComponentSignature make_component_signature()
+    {
+        ComponentSignature signature;
+
+        (signature.set(component_id_of<Ts>()), ...);
+
+        return signature;
+    }
+
     class IComponent
     {
     public:
@@ -53,9 +111,9 @@ namespace forge
             return m_is_enabled;
         }
 
-        virtual Array<std::type_index> get_bundle() { return {}; }
+        virtual FrameArray<std::type_index> get_bundle() { return {}; }
 
-        virtual Array<ComponentField> export_fields() { return {}; }
+        virtual FrameArray<ComponentField> export_fields() { return {}; }
 
         // gets the type this component should be registered as useful for ensuring derived classes
         // will always get registered as its base interface
@@ -71,6 +129,8 @@ namespace forge
 
     private:
         friend Nexus;
+        template<class ...Ts>
+        friend class NexusView;
         // if false this component has been freed
         bool m_is_valid = true;
         // if false this component should not be updated
@@ -96,6 +156,12 @@ namespace forge
         void stop_timer(TimerID id) const;
     };
 
+    // any component type that does not derive from IComponent is treated as plain data and is stored inside
+    // the nexus archetype storage instead of getting its own pool
+    template<class T>
+    concept ArchetypeComponent = std::is_class_v<T> && !std::derived_from<T, IComponent> &&
+        std::is_default_constructible_v<T> && std::is_move_constructible_v<T>;
+
     class Entity final
     {
     public:
@@ -116,7 +182,7 @@ namespace forge
         template<class T>
         T* get_component();
 
-        VirtualArray<Entity> get_children() const;
+        const EntityArray& get_children() const;
 
         [[nodiscard]]
         inline bool has_children() const
@@ -133,6 +199,12 @@ namespace forge
             return m_id;
         }
 
+        [[nodiscard]]
+        inline EntityHandle get_handle() const
+        {
+            return m_handle;
+        }
+
         [[nodiscard]]
         inline Transform& get_transform()
         {
@@ -162,9 +234,33 @@ namespace forge
         void set_name(std::string_view new_name);
 
         [[nodiscard]]
-        inline const HashMap<std::type_index, IComponent*>& get_components() const
+        inline const ComponentSignature& get_signature() const
         {
-            return m_components;
+            return m_signature;
+        }
+
+        template<class T>
+        requires(std::derived_from<T, IComponent>)
+        [[nodiscard]]
+        inline bool has_component() const
+        {
+            return m_signature.test(component_id_of<T>());
+        }
+
+        // calls fn(type, component) for every pooled component of this entity.
+        // the current component may be removed from within fn
+        template<class Fn>
+        void for_each_component(Fn &&fn)
+        {
+            const auto signature = m_signature;
+
+            signature.for_each([&](ComponentID id)
+            {
+                if (m_signature.test(id))
+                {
+                    fn(get_component_type(id), m_components[m_signature.rank(id)]);
+                }
+            });
         }
 
         template<class ...Args>
@@ -352,14 +448,12 @@ namespace forge
 
     private:
         friend Nexus;
+        friend ArchetypeStorage;
 
-        Transform m_transform;
-
-        std::string m_name;
-
-        HashMap<std::type_index, IComponent*> m_components;
+        // the members touched by the transform pass come first so they share as few cache lines as possible,
+        // everything below m_is_valid is only needed when components or names change
 
-        Nexus *m_nexus;
+        Transform m_transform;
 
         Entity *m_parent = nullptr;
 
@@ -367,17 +461,31 @@ namespace forge
         // this is mostly for global transform calculations and for the entity dirty table
         Entity *m_top_most_parent = nullptr;
 
-        VirtualArray<Entity> m_children;
-
-        EntityID m_id;
+        EntityArray m_children;
 
-        // will be set to true if any transform component is marked dirty and signifies that this entity has been marked for cleaning
-        // is mainly used to avoid trying to add it to the dirty table more than once since the table is a vector
-        bool m_is_queued_for_cleaning = false;
+        // set once the transform of this entity changed and it was added to a dirty buffer.
+        // atomic so any thread can claim the entity without a lock and it only ends up in one buffer
+        std::atomic<bool> m_is_queued_for_cleaning = false;
 
         // set to false if this entity is deallocated
         bool m_is_valid = false;
 
+        Nexus *m_nexus;
+
+        std::string m_name;
+
+        // which component types this entity holds. the components themselves are kept in id order,
+        // so the rank of a bit in the signature is the index of its component
+        ComponentSignature m_signature;
+        std::array<IComponent*, ECS_MAX_COMPONENTS_PER_ENTITY> m_components {};
+
+        // where this entities plain data components live inside the nexus archetype storage
+        ArchetypeLocation m_archetype_location;
+
+        EntityID m_id;
+
+        EntityHandle m_handle;
+
         Entity() = default;
 
         void update_dirty_array();
@@ -389,6 +497,8 @@ namespace forge
     // the actual function itself is not called ever
 #define REGISTER_UPDATE_FUNC void __should_ever_update__() {}
 #define SET_MAX_COMPONENT_MEMORY(amount) constexpr static size_t max_component_memory() { return (amount); }
+    // VirtualAllocFlags for the pool of this component, replaces DEFAULT_ECS_ALLOC_FLAGS
+#define SET_COMPONENT_ALLOC_FLAGS(flags) constexpr static u8 component_alloc_flags() { return (flags); }
 
     template<class T>
     concept ComponentShouldEverUpdate = requires(T t)
@@ -396,17 +506,125 @@ namespace forge
         t.__should_ever_update__();
     };
 
+    // if used within an IComponent class that also uses REGISTER_UPDATE_FUNC its instances will be split into chunks
+    // that are updated on multiple threads at once. the update function may only write to the component itself and
+    // read what was listed with COMPONENT_READS. it must not create or destroy entities, add or remove components,
+    // add timers or write to its transform. only some of this is caught by asserts in debug builds, the rest is a data race.
+    // declaring COMPONENT_WRITES on such a type does not compile since two instances could write to the same component
+#define PARALLEL_UPDATE void __parallel_update__() {}
+
+    template<class T>
+    concept ComponentParallelUpdate = requires(T t)
+    {
+        t.__parallel_update__();
+    };
+
+    // if used within an IComponent class its pool is kept densely packed. holes left by destroyed components are filled
+    // with the last components of the pool at the start of the next nexus update, so updates only walk live components.
+    // components get moved around by this, so nothing but their owner may keep a pointer to them (timers and signals
+    // capturing this included), get_id stays the same though
+#define COMPACT_STORAGE void __compact_storage__() {}
+
+    template<class T>
+    concept ComponentCompactStorage = requires(T t)
+    {
+        t.__compact_storage__();
+    };
+
+    // true while the calling thread is running component updates at the same time as other threads
+    inline thread_local bool g_is_in_concurrent_update = false;
+
+    template<class ...Ts>
+    struct TypeList {};
+
+    // declares which other component types the update function of a component reads and writes. Transform can be listed
+    // as well if the update touches transforms. a component always counts as writing to its own type.
+    // component types that declare their access get updated at the same time as other types they don't conflict with,
+    // so their update must not create or destroy entities, add or remove components, add timers or touch anything not listed.
+    // components that don't declare anything are assumed to touch everything and are always updated on their own
+#define COMPONENT_READS(...) using __component_reads__ = forge::TypeList<__VA_ARGS__>;
+#define COMPONENT_WRITES(...) using __component_writes__ = forge::TypeList<__VA_ARGS__>;
+
+    struct ComponentAccess
+    {
+        Array<std::type_index> reads;
+        Array<std::type_index> writes;
+        bool is_declared = false;
+
+        [[nodiscard]]
+        bool conflicts_with(const ComponentAccess &other) const;
+    };
+
+    template<class T>
+    ComponentAccess make_component_access()
+    {
+        ComponentAccess access;
+
+        auto append = [](Array<std::type_index> &out, auto list)
+        {
+            [&]<class ...Ts>(TypeList<Ts...>)
+            {
+                (out.emplace_back(typeid(Ts)), ...);
+            }(list);
+        };
+
+        if constexpr (requires { typename T::__component_reads__; })
+        {
+            access.is_declared = true;
+            append(access.reads, typename T::__component_reads__{});
+        }
+
+        if constexpr (requires { typename T::__component_writes__; })
+        {
+            access.is_declared = true;
+            append(access.writes, typename T::__component_writes__{});
+        }
+
+        if (access.is_declared)
+        {
+            access.writes.emplace_back(typeid(T));
+        }
+
+        return access;
+    }
+
     class Nexus final : public ISubSystem
     {
+        typedef void(*UpdateRangeFunc)(const MemPool&, size_t first, size_t last, DeltaTime);
+
         struct ComponentType
         {
             MemPool mem_pool;
+            ComponentID id = 0;
+            // set for components tagged with REGISTER_UPDATE_FUNC. calls the concrete update directly so the
+            // compiler can inline it into the loop instead of going through the vtable for every component
+            UpdateRangeFunc update_range = nullptr;
+            ComponentAccess access;
+            bool is_parallel = false;
 
             void free(IComponent *component);
 
-            void update(DeltaTime delta) const;
+            void update(DeltaTime delta, JobSystem *job_system) const;
         };
 
+        // updates the components with an index in [first, last)
+        template<class T>
+        static void update_range(const MemPool &mem_pool, size_t first, size_t last, DeltaTime delta)
+        {
+            auto *components = (T*)mem_pool.get_memory();
+
+            for (auto i = first; i < last; i++)
+            {
+                auto &component = components[i];
+
+                if (component.m_is_valid && component.m_is_enabled) [[likely]]
+                {
+                    // qualified call so it is resolved statically
+                    component.T::update(delta);
+                }
+            }
+        }
+
     public:
 
         std::string init(const EngineInitOptions &options) override;
@@ -428,10 +646,20 @@ namespace forge
                 return false;
             }
 
+            // hand out the id now so ids follow registration order
+            const auto id = component_id_of<T>();
+
+            if (id == INVALID_COMPONENT_ID)
+            {
+                return false;
+            }
+
             auto emplaced = m_component_table.emplace(type, ComponentType{});
 
             auto &ct = emplaced.first->second;
 
+            ct.id = id;
+
             auto component_size = DEFAULT_ECS_MAX_MAPPED_MEMORY;
 
             if constexpr (requires { T::max_component_memory; })
@@ -439,16 +667,51 @@ namespace forge
                 component_size = T::max_component_memory();
             }
 
-            auto result = ct.mem_pool.init<T>(component_size);
+            u8 alloc_flags = DEFAULT_ECS_ALLOC_FLAGS;
+
+            if constexpr (requires { T::component_alloc_flags; })
+            {
+                alloc_flags = T::component_alloc_flags();
+            }
+
+            auto result = ct.mem_pool.init<T>(component_size, alloc_flags);
 
             if (!result)
             {
+                m_component_table.erase(type);
                 return false;
             }
 
+            refresh_component_types();
+
+            if constexpr (ComponentCompactStorage<T>)
+            {
+                ct.mem_pool.set_compact([](u8 *destination, u8 *source)
+                {
+                    auto *previous = (T*)source;
+                    auto *component = new (destination) T(std::move(*previous));
+                    previous->~T();
+
+                    on_component_relocated(previous, component);
+                });
+            }
+
+            static_assert(!ComponentParallelUpdate<T> || ComponentShouldEverUpdate<T>,
+                "PARALLEL_UPDATE has to be used together with REGISTER_UPDATE_FUNC");
+            static_assert(!ComponentParallelUpdate<T> || !requires { typename T::__component_writes__; },
+                "PARALLEL_UPDATE types can't write to other components, remove COMPONENT_WRITES or PARALLEL_UPDATE");
+
+            if constexpr (ComponentShouldEverUpdate<T>)
+            {
+                ct.update_range = &update_range<T>;
+                ct.is_parallel = ComponentParallelUpdate<T>;
+            }
+
             if (ComponentShouldEverUpdate<T> || override_should_update)
             {
+                ct.access = make_component_access<T>();
                 m_update_table.emplace_back(type);
+                m_is_update_schedule_dirty = true;
             }
 
             return emplaced.second;
@@ -485,6 +748,31 @@ namespace forge
             return entity;
         }
 
+        // creates count entities that all hold Args. the pooled components of each type are allocated as one contiguous
+        // range of their pool and set up in a single pass per type instead of going through add_component per entity.
+        // bundles and register types are looked up once per type so they have to be the same for every instance
+        template<class ...Args>
+        Array<Entity*> create_entities(u32 count, Entity *parent = nullptr)
+        {
+            ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+            Array<Entity*> entities;
+            entities.reserve(count);
+
+            m_entity_slots.reserve(m_entity_slots.size() + count);
+
+            for (u32 i = 0; i < count; i++)
+            {
+                entities.push_back(create_entity("", parent));
+            }
+
+            (add_component_to_all<Args>(entities), ...);
+
+            return entities;
+        }
+
+        void destroy_entities(std::span<Entity* const> entities);
+
         void add_to_group(std::string_view group_name, Entity* entity);
 
         void remove_from_group(std::string_view group_name, Entity* entity);
@@ -493,9 +781,19 @@ namespace forge
 
         void create_group(std::string_view group_name);
 
-        // if trim_invalid_entities is true it will search the group for any entities that have been destroyed and remove them from the group
+        // groups hold on to handles, entities that have been destroyed since they were added resolve to nullptr
+        [[nodiscard]]
+        Array<EntityHandle>* get_group(std::string_view group_name);
+
+        // O(1). returns nullptr if the entity has been destroyed or the handle is null
+        [[nodiscard]]
+        Entity* resolve(EntityHandle handle) const;
+
         [[nodiscard]]
-        std::vector<Entity*>* get_group(std::string_view group_name, bool trim_invalid_entities = true);
+        inline bool is_alive(EntityHandle handle) const
+        {
+            return resolve(handle) != nullptr;
+        }
 
         [[nodiscard]]
         Entity* get_entity(std::string_view name);
@@ -512,16 +810,50 @@ namespace forge
         template<class T>
         inline T* add_component(Entity *entity)
         {
-            if (!is_component_registered<T>())
+            ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+            if constexpr (ArchetypeComponent<T>)
             {
-                register_component<T>();
+                return m_archetypes.add<T>(entity, entity->m_archetype_location);
             }
+            else
+            {
+                if (!is_component_registered<T>() && !register_component<T>())
+                {
+                    return nullptr;
+                }
 
-            return (T*)add_component(entity, typeid(T));
+                return (T*)add_component_by_id(entity, component_id_of<T>());
+            }
         }
 
        u8* add_component(Entity *entity, std::type_index index);
 
+        template<class T>
+        void add_component_to_all(std::span<Entity* const> entities)
+        {
+            ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+            if constexpr (ArchetypeComponent<T>)
+            {
+                for (auto *entity : entities)
+                {
+                    m_archetypes.add<T>(entity, entity->m_archetype_location);
+                }
+            }
+            else
+            {
+                if (!is_component_registered<T>() && !register_component<T>())
+                {
+                    return;
+                }
+
+                add_component_to_all_by_id(entities, component_id_of<T>());
+            }
+        }
+
+        void add_component_to_all(std::span<Entity* const> entities, std::type_index index);
+
         template<class ...Args>
         void add_components(Entity *entity)
         {
@@ -531,19 +863,57 @@ namespace forge
         template<class T>
         void remove_component(Entity *entity)
         {
-            remove_component(entity, typeid(T));
+            ASSERT_NOT_IN_CONCURRENT_UPDATE();
+
+            if constexpr (ArchetypeComponent<T>)
+            {
+                m_archetypes.remove(entity->m_archetype_location, typeid(T));
+            }
+            else
+            {
+                remove_component_by_id(entity, component_id_of<T>());
+            }
         }
 
         void remove_component(Entity *entity, std::type_index index);
 
         void update() override;
 
+        // queues a command that runs on the main thread once all components have been updated.
+        // this is how entities and components get created or destroyed from a concurrent update. thread safe
+        template<class Fn>
+        inline void defer(Fn &&command)
+        {
+            m_deferred_commands.emplace(std::forward<Fn>(command));
+        }
+
+        // iterates every entity that holds all of the listed pooled components. Transform may be listed as well
+        // usage: for (auto [entity, transform, mesh] : nexus.view<Transform, MeshRendererComponent>())
+        template<class ...Ts>
+        [[nodiscard]]
+        NexusView<Ts...> view();
+
+        // calls fn(Entity&, Ts&...) for every entity that owns all of the listed plain data components.
+        // entities are visited chunk by chunk so this is a linear walk over each component array
+        template<class ...Ts, class Fn>
+        requires(ArchetypeComponent<Ts> && ...)
+        inline void each(Fn &&fn)
+        {
+            m_archetypes.each<Ts...>(std::forward<Fn>(fn));
+        }
+
+        [[nodiscard]]
+        inline const ArchetypeStorage& get_archetype_storage() const
+        {
+            return m_archetypes;
+        }
+
         inline HashMap<std::type_index, ComponentType>& get_component_table()
         {
             return m_component_table;
         }
 
-        VirtualArray<Entity> get_entities();
+        const EntityArray& get_entities() const;
 
         [[nodiscard]]
         inline size_t get_entity_count() const
@@ -561,16 +931,89 @@ namespace forge
         friend Entity;
 
         HashMap<std::type_index, ComponentType> m_component_table;
+        // the entries of m_component_table indexed by their id, null for types not registered with this nexus.
+        // lets the component paths that already know the id skip the hash lookup
+        std::array<ComponentType*, ECS_MAX_COMPONENT_TYPES> m_component_types {};
+        ArchetypeStorage m_archetypes;
         HashMap<std::string_view, Entity*> m_name_table;
-        HashMap<std::string, std::vector<Entity*>, ENABLE_TRANSPARENT_HASH> m_groups;
-        // holds on to all the entities that have a dirty flag set in their hierarchy. will be cleared once updated
-        // the entity view is always the top most parent in that hierarchy. could potentially be optimized to only store
-        // the part of the hierarchy that actually needs to be updated
-        mutable std::mutex m_dirty_table_mutex;
-        std::vector<Entity*> m_entity_dirty_table;
+        HashMap<std::string, Array<EntityHandle>, ENABLE_TRANSPARENT_HASH> m_groups;
+
+        struct EntitySlot
+        {
+            Entity *entity = nullptr;
+            u32 generation = 0;
+        };
+
+        // what entity handles index into. the generation of a slot is bumped whenever its entity is destroyed
+        // and freed slots are reused by new entities
+        Array<EntitySlot> m_entity_slots;
+        Array<u32> m_free_entity_slots;
+        // entities marked dirty by a single thread. padded so threads appending at the same time don't share a cache line
+        struct alignas(ECS_CACHE_LINE_SIZE) DirtyBuffer
+        {
+            Array<Entity*> entities;
+        };
+
+        // the entities whose own transform changed since the last transform pass, one buffer per job system thread
+        // indexed by g_job_thread_index. only they and their descendants get their global transform recomputed
+        Array<DirtyBuffer> m_dirty_buffers;
+        // threads not owned by the job system share this one
+        std::mutex m_foreign_dirty_mutex;
+        Array<Entity*> m_foreign_dirty_buffer;
+        // all dirty buffers merged together at the start of the transform pass
+        Array<Entity*> m_processing_dirty_table;
+        // every subtree that needs to be recomputed flattened in level order so parents always come before their children
+        Array<Entity*> m_transform_pass;
+        // the end index into m_transform_pass of every subtree
+        Array<u32> m_transform_pass_ranges;
+        // the local components, parent matrices and outputs of m_transform_pass gathered for the batched kernel
+        TransformSoA m_transform_soa;
+        Array<const glm::mat4*> m_transform_parents;
+        Array<glm::mat4*> m_transform_outputs;
         std::vector<std::type_index> m_update_table;
-        VirtualArray<Entity> m_entities;
+        // the update table split into levels. types within a level don't conflict and are updated concurrently,
+        // levels run one after another. rebuilt whenever the update table changes
+        Array<Array<std::type_index>> m_update_schedule;
+        bool m_is_update_schedule_dirty = false;
+        // null when running without a job system in which case everything is updated on the calling thread
+        JobSystem *m_job_system = nullptr;
+        CommandBuffer<> m_deferred_commands;
+        EntityArray m_entities;
         u64 m_id_counter {};
+
+        // points m_component_types at the entries of m_component_table again, which move whenever it changes
+        void refresh_component_types();
+
+        u8* add_component_by_id(Entity *entity, ComponentID id);
+
+        void add_component_to_all_by_id(std::span<Entity* const> entities, ComponentID requested_id);
+
+        void remove_component_by_id(Entity *entity, ComponentID id);
+
+        void build_update_schedule();
+
+        void update_transforms();
+
+        // appends the entity and all of its descendants to the transform pass in level order
+        void flatten_hierarchy(Entity *root);
+
+        void queue_dirty_entity(Entity *entity);
+
+        // runs the destructor of every entity that was ever placed in array, children included. freed entities are
+        // kept around with their children array and name so their slot can be reused, so they need it as well
+        static void destroy_all_entities(EntityArray &array);
+
+        // places component into the component array of entity, replacing whatever was stored under the same id.
+        // false if the array is already full or id is invalid, the caller still owns component then
+        static bool insert_component(Entity *entity, ComponentID id, IComponent *component);
+
+        // points the owner of a component that was moved by compaction at its new location
+        static void on_component_relocated(IComponent *previous, IComponent *component);
+
+        // fills the holes of every COMPACT_STORAGE pool. must not run while components are being updated
+        void compact_component_pools();
+
+        void update_component_type(std::type_index type, DeltaTime delta);
     };
 
     template<class T>
@@ -588,14 +1031,21 @@ namespace forge
     template<class T>
     T* Entity::get_component()
     {
-        auto iter = m_components.find(typeid(T));
-
-        if (iter == m_components.end())
+        if constexpr (ArchetypeComponent<T>)
         {
-            return nullptr;
+            return m_nexus->m_archetypes.template get<T>(m_archetype_location);
         }
+        else
+        {
+            const auto id = component_id_of<T>();
 
-        return (T*)iter->second;
+            if (!m_signature.test(id))
+            {
+                return nullptr;
+            }
+
+            return (T*)m_components[m_signature.rank(id)];
+        }
     }
 
     template<class ... Args>
@@ -610,3 +1060,5 @@ namespace forge
         return m_nexus->remove_component<T>(this);
     }
 }
+
+#include "nexus_view.hpp"
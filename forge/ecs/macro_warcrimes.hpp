@@ -37,7 +37,7 @@
 #define EXPAND_FIELD_31(field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19, field20, field21, field22, field23, field24, field25, field26, field27, field28, field29, field30, field31) FIELD_ENTRY(field1), FIELD_ENTRY(field2), FIELD_ENTRY(field3), FIELD_ENTRY(field4), FIELD_ENTRY(field5), FIELD_ENTRY(field6), FIELD_ENTRY(field7), FIELD_ENTRY(field8), FIELD_ENTRY(field9), FIELD_ENTRY(field10), FIELD_ENTRY(field11), FIELD_ENTRY(field12), FIELD_ENTRY(field13), FIELD_ENTRY(field14), FIELD_ENTRY(field15), FIELD_ENTRY(field16), FIELD_ENTRY(field17), FIELD_ENTRY(field18), FIELD_ENTRY(field19), FIELD_ENTRY(field20), FIELD_ENTRY(field21), FIELD_ENTRY(field22), FIELD_ENTRY(field23), FIELD_ENTRY(field24), FIELD_ENTRY(field25), FIELD_ENTRY(field26), FIELD_ENTRY(field27), FIELD_ENTRY(field28), FIELD_ENTRY(field29), FIELD_ENTRY(field30), FIELD_ENTRY(field31)
 #define EXPAND_FIELD_32(field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19, field20, field21, field22, field23, field24, field25, field26, field27, field28, field29, field30, field31, field32) FIELD_ENTRY(field1), FIELD_ENTRY(field2), FIELD_ENTRY(field3), FIELD_ENTRY(field4), FIELD_ENTRY(field5), FIELD_ENTRY(field6), FIELD_ENTRY(field7), FIELD_ENTRY(field8), FIELD_ENTRY(field9), FIELD_ENTRY(field10), FIELD_ENTRY(field11), FIELD_ENTRY(field12), FIELD_ENTRY(field13), FIELD_ENTRY(field14), FIELD_ENTRY(field15), FIELD_ENTRY(field16), FIELD_ENTRY(field17), FIELD_ENTRY(field18), FIELD_ENTRY(field19), FIELD_ENTRY(field20), FIELD_ENTRY(field21), FIELD_ENTRY(field22), FIELD_ENTRY(field23), FIELD_ENTRY(field24), FIELD_ENTRY(field25), FIELD_ENTRY(field26), FIELD_ENTRY(field27), FIELD_ENTRY(field28), FIELD_ENTRY(field29), FIELD_ENTRY(field30), FIELD_ENTRY(field31), FIELD_ENTRY(field32)
 #define GET_EXPAND_FIELD_MACRO(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
-#define EXPORT_FIELDS(...) std::vector<forge::ComponentField> export_fields() override { return { GET_EXPAND_FIELD_MACRO(__VA_ARGS__, EXPAND_FIELD_32, EXPAND_FIELD_31, EXPAND_FIELD_30, EXPAND_FIELD_29, EXPAND_FIELD_28, EXPAND_FIELD_27, EXPAND_FIELD_26, EXPAND_FIELD_25, EXPAND_FIELD_24, EXPAND_FIELD_23, EXPAND_FIELD_22, EXPAND_FIELD_21, EXPAND_FIELD_20, EXPAND_FIELD_19, EXPAND_FIELD_18, EXPAND_FIELD_17, EXPAND_FIELD_16, EXPAND_FIELD_15, EXPAND_FIELD_14, EXPAND_FIELD_13, EXPAND_FIELD_12, EXPAND_FIELD_11, EXPAND_FIELD_10, EXPAND_FIELD_9, EXPAND_FIELD_8, EXPAND_FIELD_7, EXPAND_FIELD_6, EXPAND_FIELD_5, EXPAND_FIELD_4, EXPAND_FIELD_3, EXPAND_FIELD_2, EXPAND_FIELD_1)(__VA_ARGS__) };} \
+#define EXPORT_FIELDS(...) forge::FrameArray<forge::ComponentField> export_fields() override { return { GET_EXPAND_FIELD_MACRO(__VA_ARGS__, EXPAND_FIELD_32, EXPAND_FIELD_31, EXPAND_FIELD_30, EXPAND_FIELD_29, EXPAND_FIELD_28, EXPAND_FIELD_27, EXPAND_FIELD_26, EXPAND_FIELD_25, EXPAND_FIELD_24, EXPAND_FIELD_23, EXPAND_FIELD_22, EXPAND_FIELD_21, EXPAND_FIELD_20, EXPAND_FIELD_19, EXPAND_FIELD_18, EXPAND_FIELD_17, EXPAND_FIELD_16, EXPAND_FIELD_15, EXPAND_FIELD_14, EXPAND_FIELD_13, EXPAND_FIELD_12, EXPAND_FIELD_11, EXPAND_FIELD_10, EXPAND_FIELD_9, EXPAND_FIELD_8, EXPAND_FIELD_7, EXPAND_FIELD_6, EXPAND_FIELD_5, EXPAND_FIELD_4, EXPAND_FIELD_3, EXPAND_FIELD_2, EXPAND_FIELD_1)(__VA_ARGS__) };} \
 
 
 
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <typeindex>
+
+#include "ecs.hpp"
+
+namespace forge
+{
+	// the entity transform can be requested in a view like any other component. every entity has one
+	template<class T>
+	concept ViewTransform = std::same_as<T, Transform>;
+
+	template<class T>
+	concept ViewComponent = ViewTransform<T> || std::derived_from<T, IComponent>;
+
+	// iterates over every entity that holds all of the listed components.
+	// iteration is driven by the smallest component pool so the cost scales with the rarest component
+	// instead of the total entity count. disabled and freed components are skipped
+	template<class ...Ts>
+	class NexusView
+	{
+		static_assert(sizeof...(Ts) > 0, "a view needs at least one component type");
+		static_assert((ViewComponent<Ts> && ...), "views can only be made over pooled components or Transform");
+		static_assert((!ViewTransform<Ts> || ...), "a view needs at least one pooled component to drive it");
+
+		static constexpr auto TYPE_COUNT = sizeof...(Ts);
+
+	public:
+		using Value = std::tuple<Entity&, Ts&...>;
+
+		class Iterator
+		{
+		public:
+			using value_type = Value;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			Iterator(const NexusView *view, u8 *current) :
+				m_view(view),
+				m_current(current)
+			{
+				find_next_match();
+			}
+
+			Value operator*() const
+			{
+				return std::apply([this](auto *...components) -> Value
+				{
+					return {*m_entity, *components...};
+				}, m_components);
+			}
+
+			Iterator& operator++()
+			{
+				m_current += m_view->m_stride;
+				find_next_match();
+				return *this;
+			}
+
+			bool operator==(const Iterator &other) const
+			{
+				return m_current == other.m_current;
+			}
+
+			bool operator!=(const Iterator &other) const
+			{
+				return m_current != other.m_current;
+			}
+
+		private:
+			const NexusView *m_view;
+			u8 *m_current;
+			Entity *m_entity = nullptr;
+			std::tuple<Ts*...> m_components {};
+
+			void find_next_match()
+			{
+				for (; m_current != m_view->m_end; m_current += m_view->m_stride)
+				{
+					auto *driver = (IComponent*)m_current;
+
+					if (!driver->m_is_valid || !driver->m_is_enabled)
+					{
+						continue;
+					}
+
+					m_entity = driver->m_owner;
+
+					// rejects entities missing one of the other components with a single and before looking any of them up
+					if (!m_entity->get_signature().contains(m_view->m_required))
+					{
+						continue;
+					}
+
+					if (resolve(std::index_sequence_for<Ts...>{}))
+					{
+						return;
+					}
+				}
+			}
+
+			template<size_t ...I>
+			bool resolve(std::index_sequence<I...>)
+			{
+				return (resolve_one<I>() && ...);
+			}
+
+			template<size_t I>
+			bool resolve_one()
+			{
+				using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+				auto &out = std::get<I>(m_components);
+
+				if constexpr (ViewTransform<T>)
+				{
+					out = &m_entity->get_transform();
+					return true;
+				}
+				else
+				{
+					if (I == m_view->m_driver)
+					{
+						out = (T*)m_current;
+						return true;
+					}
+
+					out = m_entity->template get_component<T>();
+
+					return out != nullptr && ((IComponent*)out)->m_is_enabled;
+				}
+			}
+		};
+
+		NexusView() = default;
+
+		// pools holds the mempool of every listed component or nullptr for the transform
+		explicit NexusView(const std::array<const MemPool*, TYPE_COUNT> &pools)
+		{
+			const MemPool *smallest = nullptr;
+
+			for (u32 i = 0; i < TYPE_COUNT; i++)
+			{
+				auto *pool = pools[i];
+
+				if (pool == nullptr)
+				{
+					continue;
+				}
+
+				if (smallest == nullptr || pool->get_length() < smallest->get_length())
+				{
+					smallest = pool;
+					m_driver = i;
+				}
+			}
+
+			if (smallest == nullptr || smallest->get_length() == 0)
+			{
+				return;
+			}
+
+			[&]<size_t ...I>(std::index_sequence<I...>)
+			{
+				(add_required<I, Ts>(), ...);
+			}(std::index_sequence_for<Ts...>{});
+
+			m_begin = smallest->get_memory();
+			m_end = m_begin + smallest->get_offset();
+			m_stride = smallest->get_element_size();
+		}
+
+		Iterator begin() const
+		{
+			return {this, m_begin};
+		}
+
+		Iterator end() const
+		{
+			return {this, m_end};
+		}
+
+		// calls fn(Entity&, Ts&...) for every matching entity
+		template<class Fn>
+		void each(Fn &&fn) const
+		{
+			for (auto value : *this)
+			{
+				std::apply(fn, value);
+			}
+		}
+
+	private:
+		u8 *m_begin = nullptr;
+		u8 *m_end = nullptr;
+		size_t m_stride = 0;
+		// index into Ts of the component type whose pool drives the iteration
+		size_t m_driver = 0;
+		// the pooled component types every match has to hold besides the driving one
+		ComponentSignature m_required;
+
+		template<size_t I, class T>
+		void add_required()
+		{
+			if constexpr (!ViewTransform<T>)
+			{
+				if (I != m_driver)
+				{
+					m_required.set(component_id_of<T>());
+				}
+			}
+		}
+	};
+
+	template<class ... Ts>
+	NexusView<Ts...> Nexus::view()
+	{
+		std::array<const MemPool*, sizeof...(Ts)> pools {};
+
+		auto has_missing_pool = false;
+
+		auto find_pool = [&]<class T>(u32 i)
+		{
+			if constexpr (!ViewTransform<T>)
+			{
+				const auto id = component_id_of<T>();
+				auto *ct = id == INVALID_COMPONENT_ID ? nullptr : m_component_types[id];
+
+				if (ct == nullptr)
+				{
+					has_missing_pool = true;
+					return;
+				}
+
+				pools[i] = &ct->mem_pool;
+			}
+		};
+
+		[&]<size_t ...I>(std::index_sequence<I...>)
+		{
+			(find_pool.template operator()<Ts>(I), ...);
+		}(std::index_sequence_for<Ts...>{});
+
+		// a type that was never registered can not have any instances so nothing can match
+		if (has_missing_pool)
+		{
+			return {};
+		}
+
+		return NexusView<Ts...>{pools};
+	}
+}
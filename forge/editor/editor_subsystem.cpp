@@ -341,6 +341,7 @@ protected:
 				ImGui::Text("FPS: %d", (int)last_frame);
 				ImGui::Text("Tick: %f", last_engine_delta);
 				ImGui::Text("Draw calls: %d", render_stats.draw_calls);
+				ImGui::Text("Culled objects: %u", render_stats.culled_objects);
 				ImGui::Text("Entity count: %d", m_nexus->get_entity_count());
 
 				ImGui::EndTabItem();
@@ -648,7 +649,9 @@ protected:
 				ImGui::EndPopup();
 			}
 
-			for (auto i = 0; auto &[index, component] : m_selected_entity->get_components())
+			auto i = 0;
+
+			m_selected_entity->for_each_component([&](std::type_index index, forge::IComponent *component)
 			{
 				auto is_enabled = component->is_enabled();
 
@@ -679,7 +682,7 @@ protected:
 						m_selected_entity->remove_component(index);
 					}
 				}
-			}
+			});
 		}
 	}
 
@@ -691,7 +694,7 @@ protected:
 			{
 				m_is_in_group_tab = false;
 
-				auto entities = g_engine.nexus->get_entities();
+				auto &entities = g_engine.nexus->get_entities();
 
 				show_entities(entities);
 
@@ -743,9 +746,11 @@ protected:
 					},
 				});
 
-				for (auto *entity : entities)
+				for (auto handle : entities)
 				{
-					if (!entity->is_valid())
+					auto *entity = m_nexus->resolve(handle);
+
+					if (entity == nullptr)
 					{
 						continue;
 					}
@@ -849,7 +854,7 @@ protected:
 		}
 	}
 
-	void show_entities(forge::VirtualArray<forge::Entity> entities, std::string_view from_group = "")
+	void show_entities(const forge::EntityArray &entities, std::string_view from_group = "")
 	{
 		for (auto &entity : entities)
 		{
@@ -3,6 +3,8 @@
 #include <functional>
 #include <limits>
 
+#include "forge/memory/frame_arena.hpp"
+
 namespace forge
 {
     template<class T>
@@ -148,9 +150,10 @@ namespace forge
             }
         }
 
-        std::vector<R> call_with_return_values(A ...a) const
+        // the values live in the frame arena of the calling thread, copy them out if they are needed past this frame
+        FrameArray<R> call_with_return_values(A ...a) const
         {
-            std::vector<R> values;
+            FrameArray<R> values;
 
             values.reserve(m_connections.size());
 
@@ -1,6 +1,7 @@
 #include "timer.hpp"
 
 #include "forge/core/engine.hpp"
+#include "forge/ecs/ecs.hpp"
 
 forge::Timer::Timer(size_t max_timers)
 {
@@ -31,7 +32,7 @@ void forge::Timer::stop(TimerID id)
 	m_timers.free(id);
 }
 
-void forge::Timer::process()
+void forge::Timer::process(const Nexus *nexus)
 {
 	auto current_time = Clock::now();
 	auto delta_time = current_time - m_previous_time;
@@ -41,7 +42,11 @@ void forge::Timer::process()
 
 	for (auto &timer : m_timers.get_iterator<TimerOptions>())
 	{
-		if (timer.is_valid())
+		if (timer.is_valid() && !timer.owner.is_null() && (nexus == nullptr || !nexus->is_alive(timer.owner)))
+		{
+			stop(offset);
+		}
+		else if (timer.is_valid())
 		{
 			timer.remaining -= delta_time;
 
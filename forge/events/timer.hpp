@@ -5,15 +5,20 @@
 #include "signal.hpp"
 #include "forge/container/map.hpp"
 #include "forge/core/time.hpp"
+#include "forge/ecs/defs.hpp"
 #include "forge/memory/mem_pool.hpp"
 
 namespace forge
 {
+	class Nexus;
+
 	struct TimerOptions
 	{
 		Duration duration;
 		Duration remaining;
 		Delegate<void()> on_timeout {};
+		// if set the timer is stopped instead of firing once this entity has been destroyed
+		EntityHandle owner {};
 		bool one_shot = false;
 
 		inline void invalidate()
@@ -46,7 +51,8 @@ namespace forge
 
 		void stop(TimerID id);
 
-		void process();
+		// nexus is used to check the owners of timers, timers with an owner never fire without one
+		void process(const Nexus *nexus = nullptr);
 	private:
 		MemPool m_timers;
 
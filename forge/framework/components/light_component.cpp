@@ -25,14 +25,14 @@ void forge::LightComponent::on_destroy()
 	renderer->destroy_light(m_light);
 }
 
-forge::Array<forge::ComponentField> forge::LightComponent::export_fields()
+forge::FrameArray<forge::ComponentField> forge::LightComponent::export_fields()
 {
 	if (m_light == nullptr)
 	{
 		return {};
 	}
 
-	Array<ComponentField> fields;
+	FrameArray<ComponentField> fields;
 
 	fields.reserve(8);
 
@@ -9,7 +9,7 @@ namespace forge
 	{
 	public:
 
-		Array<ComponentField> export_fields() override;
+		FrameArray<ComponentField> export_fields() override;
 
 		Light* get_light();
 
@@ -5,9 +5,9 @@
 #include "../../graphics/ogl_renderer/ogl_renderer.hpp"
 #include "forge/graphics/mesh_generator.hpp"
 
-forge::Array<forge::ComponentField> forge::MeshRendererComponent::export_fields()
+forge::FrameArray<forge::ComponentField> forge::MeshRendererComponent::export_fields()
 {
-	Array<ComponentField> out;
+	FrameArray<ComponentField> out;
 
 	out.emplace_back<forge::ComponentField>({"Set mesh", forge::ButtonField{
 			[&comp = *this]
@@ -21,7 +21,7 @@ namespace forge
 	{
 	public:
 
-		Array<ComponentField> export_fields() override;
+		FrameArray<ComponentField> export_fields() override;
 
 		void set_mesh(std::string_view path, MeshLoadOptions options = {});
 		void set_mesh(RenderObjectTree &tree);
@@ -7,12 +7,17 @@
 
 #include "mesh_loader.hpp"
 #include "../../math/transform.hpp"
+#include "forge/concurrency/job_system.hpp"
+#include "forge/core/engine.hpp"
 #include "forge/graphics/lights.hpp"
 #include "forge/graphics/mesh.hpp"
 
+// primitives with fewer vertices or indices than this are decoded on the calling thread
+#define GLTF_DECODE_BATCH_SIZE 4096
+
 namespace forge
 {
-	MeshLoaderNode load_node(cgltf_node *node, MeshLoadOptions options)
+	MeshLoaderNode load_node(cgltf_node *node, MeshLoadOptions options, JobSystem *job_system)
 	{
 		MeshLoaderNode out;
 
@@ -26,7 +31,7 @@ namespace forge
 		{
 			auto *child = node->children[i];
 
-			out.children.emplace_back(load_node(child, options));
+			out.children.emplace_back(load_node(child, options, job_system));
 		}
 
 		if (node->has_scale)
@@ -93,26 +98,48 @@ namespace forge
 				}
 			}
 
-			for (cgltf_size i = 0; i < pos_accessor->count; i++)
+			// decoding is a read only walk over the accessors so large primitives are split across the job system
+			out.mesh.vertices.resize(out.mesh.vertices.size() + pos_accessor->count);
+
+			auto *vertices = out.mesh.vertices.data() + out.mesh.vertices.size() - pos_accessor->count;
+
+			parallel_for(job_system, pos_accessor->count, GLTF_DECODE_BATCH_SIZE, [&](size_t first, size_t last)
 			{
-				Vertex vertex {};
+				for (auto i = first; i < last; i++)
+				{
+					auto &vertex = vertices[i];
 
-				cgltf_accessor_read_float(pos_accessor, i, glm::value_ptr(vertex.position), 3);
-				cgltf_accessor_read_float(tex_accessor, i, glm::value_ptr(vertex.texture), 2);
-				cgltf_accessor_read_float(norm_accessor, i, glm::value_ptr(vertex.normals), 3);
+					cgltf_accessor_read_float(pos_accessor, i, glm::value_ptr(vertex.position), 3);
+					cgltf_accessor_read_float(tex_accessor, i, glm::value_ptr(vertex.texture), 2);
+					cgltf_accessor_read_float(norm_accessor, i, glm::value_ptr(vertex.normals), 3);
 
-				vertex.position *= options.uniform_scale;
+					vertex.position *= options.uniform_scale;
+				}
+			});
 
-				out.mesh.vertices.emplace_back(vertex);
+			// gltf requires min and max on positions, only files that break the spec have to be walked again
+			if (pos_accessor->has_min && pos_accessor->has_max)
+			{
+				out.mesh.bounds.expand(glm::make_vec3(pos_accessor->min) * options.uniform_scale);
+				out.mesh.bounds.expand(glm::make_vec3(pos_accessor->max) * options.uniform_scale);
 			}
-
-			for (cgltf_size i = 0; i < prim->indices->count; i++)
+			else
 			{
-				auto index = cgltf_accessor_read_index(prim->indices, i);
-
-				out.mesh.indices.emplace_back(index + vertex_offset);
+				out.mesh.bounds.expand(compute_extents({vertices, (u32)pos_accessor->count}));
 			}
 
+			out.mesh.indices.resize(out.mesh.indices.size() + prim->indices->count);
+
+			auto *indices = out.mesh.indices.data() + out.mesh.indices.size() - prim->indices->count;
+
+			parallel_for(job_system, prim->indices->count, GLTF_DECODE_BATCH_SIZE, [&](size_t first, size_t last)
+			{
+				for (auto i = first; i < last; i++)
+				{
+					indices[i] = cgltf_accessor_read_index(prim->indices, i) + vertex_offset;
+				}
+			});
+
 			Submesh submesh;
 
 			submesh.index_offset = index_offset;
@@ -190,7 +217,7 @@ namespace forge
 
 		auto *root = data->scene->nodes[0];
 
-		out = load_node(root, options);
+		out = load_node(root, options, g_engine.get_subsystem<JobSystem>());
 
 		cgltf_free(data);
 
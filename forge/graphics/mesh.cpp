@@ -5,5 +5,18 @@ forge::MeshView::MeshView(Mesh &mesh) :
 	vertices(mesh.vertices),
 	indices(mesh.indices),
 	materials(mesh.materials),
-	submeshes(mesh.submeshes)
+	submeshes(mesh.submeshes),
+	bounds(mesh.bounds)
 {}
+
+forge::Extents forge::compute_extents(View<Vertex> vertices)
+{
+	Extents out;
+
+	for (u32 i = 0; i < vertices.size; i++)
+	{
+		out.expand(vertices.data[i].position);
+	}
+
+	return out;
+}
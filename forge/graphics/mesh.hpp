@@ -9,6 +9,7 @@
 #include "forge/container/array.hpp"
 #include "forge/container/string.hpp"
 #include "forge/container/view.hpp"
+#include "forge/math/extents.hpp"
 
 namespace forge
 {
@@ -33,6 +34,8 @@ namespace forge
 		Array<u32> indices;
 		Array<Material> materials;
 		Array<Submesh> submeshes;
+		// local space bounds of all vertices, empty if the loader did not fill them in
+		Extents bounds;
 	};
 
 	// a trivially copyable view to a mesh
@@ -43,9 +46,13 @@ namespace forge
 		View<u32> indices;
 		View<Material> materials;
 		View<Submesh> submeshes;
+		Extents bounds;
 
 		MeshView() = default;
 
 		MeshView(Mesh &mesh);
 	};
+
+	[[nodiscard]]
+	Extents compute_extents(View<Vertex> vertices);
 }
@@ -71,6 +71,8 @@ namespace forge
 		mesh.indices.emplace_back(22); mesh.indices.emplace_back(21); mesh.indices.emplace_back(20);
 		mesh.indices.emplace_back(23); mesh.indices.emplace_back(21); mesh.indices.emplace_back(22);
 
+		mesh.bounds = compute_extents(mesh.vertices);
+
 		return mesh;
 	}
 }
@@ -0,0 +1,142 @@
+#include "ogl_geometry_heap.hpp"
+
+#include <algorithm>
+
+#define OGL_GEOMETRY_BINDING 0
+
+forge::OglGeometryHeap::~OglGeometryHeap()
+{
+	destroy();
+}
+
+void forge::OglGeometryHeap::init(u32 vertex_capacity, u32 index_capacity)
+{
+	m_vertices.capacity = vertex_capacity;
+	m_vertices.buffer = create_buffer(vertex_capacity * sizeof(Vertex));
+
+	m_indices.capacity = index_capacity;
+	m_indices.buffer = create_buffer(index_capacity * sizeof(u32));
+
+	glCreateVertexArrays(1, &m_vao);
+
+	// position, texture coordinates, normal
+	glEnableVertexArrayAttrib(m_vao, 0);
+	glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+	glVertexArrayAttribBinding(m_vao, 0, OGL_GEOMETRY_BINDING);
+
+	glEnableVertexArrayAttrib(m_vao, 1);
+	glVertexArrayAttribFormat(m_vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, texture));
+	glVertexArrayAttribBinding(m_vao, 1, OGL_GEOMETRY_BINDING);
+
+	glEnableVertexArrayAttrib(m_vao, 2);
+	glVertexArrayAttribFormat(m_vao, 2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normals));
+	glVertexArrayAttribBinding(m_vao, 2, OGL_GEOMETRY_BINDING);
+
+	bind_buffers();
+}
+
+void forge::OglGeometryHeap::destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vertices.buffer);
+		glDeleteBuffers(1, &m_indices.buffer);
+	}
+
+	m_vao = 0;
+	m_vertices = {};
+	m_indices = {};
+}
+
+forge::OglGeometryAllocation forge::OglGeometryHeap::allocate(View<Vertex> vertices, View<u32> indices)
+{
+	OglGeometryAllocation allocation;
+
+	allocation.vertex_count = vertices.size;
+	allocation.index_count = indices.size;
+	allocation.first_vertex = allocate_range(m_vertices, vertices.size, sizeof(Vertex));
+	allocation.first_index = allocate_range(m_indices, indices.size, sizeof(u32));
+
+	glNamedBufferSubData(m_vertices.buffer, allocation.first_vertex * sizeof(Vertex), vertices.size * sizeof(Vertex), vertices.data);
+	glNamedBufferSubData(m_indices.buffer, allocation.first_index * sizeof(u32), indices.size * sizeof(u32), indices.data);
+
+	return allocation;
+}
+
+void forge::OglGeometryHeap::free(const OglGeometryAllocation &allocation)
+{
+	free_range(m_vertices, allocation.first_vertex, allocation.vertex_count);
+	free_range(m_indices, allocation.first_index, allocation.index_count);
+}
+
+void forge::OglGeometryHeap::bind() const
+{
+	glBindVertexArray(m_vao);
+}
+
+u32 forge::OglGeometryHeap::create_buffer(size_t size)
+{
+	u32 buffer;
+
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	return buffer;
+}
+
+u32 forge::OglGeometryHeap::allocate_range(Region &region, u32 count, u32 element_size)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	if (auto first = region.free_ranges.allocate(count))
+	{
+		return *first;
+	}
+
+	if (region.end + count > region.capacity)
+	{
+		const auto capacity = std::max(region.capacity * 2, region.end + count);
+		const auto buffer = create_buffer(size_t(capacity) * element_size);
+
+		// draws that were already submitted keep reading from the old buffer until they are done
+		glCopyNamedBufferSubData(region.buffer, buffer, 0, 0, size_t(region.end) * element_size);
+		glDeleteBuffers(1, &region.buffer);
+
+		region.buffer = buffer;
+		region.capacity = capacity;
+
+		bind_buffers();
+	}
+
+	const auto first = region.end;
+
+	region.end += count;
+
+	return first;
+}
+
+void forge::OglGeometryHeap::free_range(Region &region, u32 first, u32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	region.free_ranges.free(first, count);
+
+	// ranges freed at the end go back to the bump allocator so the free list stays short
+	if (auto range = region.free_ranges.pop_range_ending_at(region.end))
+	{
+		region.end = range->first;
+	}
+}
+
+void forge::OglGeometryHeap::bind_buffers()
+{
+	glVertexArrayVertexBuffer(m_vao, OGL_GEOMETRY_BINDING, m_vertices.buffer, 0, sizeof(Vertex));
+	glVertexArrayElementBuffer(m_vao, m_indices.buffer);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "forge/container/view.hpp"
+#include "forge/graphics/mesh.hpp"
+#include "forge/memory/free_range_list.hpp"
+
+#define OGL_GEOMETRY_HEAP_INITIAL_VERTICES (256 * 1024)
+#define OGL_GEOMETRY_HEAP_INITIAL_INDICES (1024 * 1024)
+
+namespace forge
+{
+	// where a mesh lives inside the geometry heap. indices stay relative to the mesh, draws add first_vertex
+	// through base_vertex and first_index through their own first_index
+	struct OglGeometryAllocation
+	{
+		u32 first_vertex {};
+		u32 vertex_count {};
+		u32 first_index {};
+		u32 index_count {};
+	};
+
+	// one vertex and one index buffer shared by every mesh with the Vertex layout, along with the only vao that
+	// is needed to draw them. meshes are placed first fit in the freed ranges and at the end otherwise,
+	// the buffers double in size when they run out of space
+	class OglGeometryHeap
+	{
+	public:
+		OglGeometryHeap() = default;
+		~OglGeometryHeap();
+
+		OglGeometryHeap(const OglGeometryHeap &) = delete;
+		OglGeometryHeap& operator=(const OglGeometryHeap &) = delete;
+
+		void init(u32 vertex_capacity = OGL_GEOMETRY_HEAP_INITIAL_VERTICES, u32 index_capacity = OGL_GEOMETRY_HEAP_INITIAL_INDICES);
+		void destroy();
+
+		[[nodiscard]]
+		OglGeometryAllocation allocate(View<Vertex> vertices, View<u32> indices);
+
+		void free(const OglGeometryAllocation &allocation);
+
+		void bind() const;
+
+		[[nodiscard]]
+		inline u32 get_vao() const
+		{
+			return m_vao;
+		}
+
+	private:
+		// a buffer that is sub allocated in whole elements
+		struct Region
+		{
+			u32 buffer = 0;
+			u32 capacity = 0;
+			// everything past this has never been handed out
+			u32 end = 0;
+			FreeRangeList free_ranges;
+		};
+
+		u32 m_vao = 0;
+		Region m_vertices;
+		Region m_indices;
+
+		static u32 create_buffer(size_t size);
+
+		// returns the first element of a count sized range, regrowing the buffer if needed
+		u32 allocate_range(Region &region, u32 count, u32 element_size);
+
+		void free_range(Region &region, u32 first, u32 count);
+
+		void bind_buffers();
+	};
+}
@@ -1,5 +1,6 @@
 #include "ogl_renderer.hpp"
 
+#include <atomic>
 #include <set>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -13,8 +14,10 @@
 #include "forge/fmt/fmt.hpp"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
+#include "forge/concurrency/job_system.hpp"
 #include "forge/core/engine.hpp"
 #include "forge/core/logging.hpp"
+#include "../../math/frustum.hpp"
 #include "../../math/transform.hpp"
 #include "forge/graphics/mesh.hpp"
 #include "forge/graphics/mesh_primitives.hpp"
@@ -26,37 +29,17 @@
 
 #define CAMERA_POOL_SIZE sizeof(forge::Camera) * 16
 #define RENDER_DATA_POOL_SIZE MB(2048)
+// below this many render objects the per object matrices are computed on the render thread
+#define OGL_PREPARE_BATCH_SIZE 1024
+// starting sizes of the per frame buffers, both grow when a frame needs more
+#define OGL_INITIAL_OBJECT_COUNT 1024
+#define OGL_INITIAL_DRAW_COMMAND_COUNT 4096
 
-struct OglDrawElementsIndirectCommand
+static constexpr forge::TextureList<std::string_view> g_material_texture_str
 {
-	u32 count			{};
-	u32 instance_count	{};
-	u32 first_index		{};
-	u32 base_vertex		{};
-	u32 base_instance	{};
-};
-
-static constexpr forge::TextureList<std::array<std::string_view, 4>> g_material_prop_str
-{
-	std::array<std::string_view, 4>
-	{
-		"material.diffuse.texture",
-		"material.diffuse.enabled",
-		"material.diffuse.scale",
-		"material.diffuse.strength",
-	},
-	{
-		"material.specular.texture",
-		"material.specular.enabled",
-		"material.specular.scale",
-		"material.specular.strength",
-	},
-	{
-		"material.emissive.texture",
-		"material.emissive.enabled",
-		"material.emissive.scale",
-		"material.emissive.strength",
-	}
+	"material_textures[0]",
+	"material_textures[1]",
+	"material_textures[2]",
 };
 
 std::string forge::OglRenderer::init(const EngineInitOptions &options)
@@ -89,6 +72,16 @@ std::string forge::OglRenderer::init(const EngineInitOptions &options)
 
 #undef C
 
+	init_forward_uniforms();
+
+	m_light_buffer.init(GL_SHADER_STORAGE_BUFFER, sizeof(OglLightBuffer));
+	m_object_buffer.init(GL_SHADER_STORAGE_BUFFER, OGL_INITIAL_OBJECT_COUNT * sizeof(OglObject));
+	m_draw_command_buffer.init(GL_DRAW_INDIRECT_BUFFER, OGL_INITIAL_DRAW_COMMAND_COUNT * sizeof(OglDrawElementsIndirectCommand));
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OGL_OBJECT_BUFFER_BINDING, m_object_buffer.get_buffer());
+
+	m_geometry.init();
+
 	m_texture_resource.on_resource_init = [](std::string_view path, OglTexture *texture)
 	{
 		texture->load(path);
@@ -109,21 +102,9 @@ std::string forge::OglRenderer::init(const EngineInitOptions &options)
 
 	m_active_camera = &m_default_camera;
 
-	m_render_data.init<RenderData>(RENDER_DATA_POOL_SIZE);
-
-	GLuint ubo;
-	glGenBuffers(1, &ubo);
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	m_job_system = g_engine.get_subsystem<JobSystem>();
 
-	glBufferStorage(GL_UNIFORM_BUFFER, sizeof(Material), nullptr,
-		GL_MAP_WRITE_BIT |
-		GL_MAP_PERSISTENT_BIT |
-		GL_MAP_COHERENT_BIT);
-
-	m_material_ubo = (Material*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Material),
-		GL_MAP_WRITE_BIT |
-		GL_MAP_PERSISTENT_BIT |
-		GL_MAP_COHERENT_BIT);
+	m_render_data.init<RenderData>(RENDER_DATA_POOL_SIZE, VirtualAllocFlags::NoReserve | VirtualAllocFlags::HugePages);
 
 	return {};
 }
@@ -136,88 +117,185 @@ void forge::OglRenderer::update()
 
 	m_forward_shader.use();
 
-	for (auto i = 0; const auto &light : m_lights)
+	upload_lights();
+
+	m_forward_shader.set(m_forward_uniforms.view_position, m_active_camera->position);
+
+	for (auto i = 0; auto handle : m_forward_uniforms.material_textures)
 	{
-		auto index = fmt::format("[{}]", i++);
+		m_forward_shader.set(handle, i++);
+	}
 
-		if (light.enabled)
-		{
-			m_forward_shader.set(fmt::format_view("lights{}.position", index), light.position);
-			m_forward_shader.set(fmt::format_view("lights{}.direction", index), light.direction);
-			m_forward_shader.set(fmt::format_view("lights{}.color", index), light.color);
-			m_forward_shader.set(fmt::format_view("lights{}.intensity", index), light.intensity);
-			m_forward_shader.set(fmt::format_view("lights{}.cutoff", index), light.cutoff);
-			m_forward_shader.set(fmt::format_view("lights{}.outer_cutoff", index), light.outer_cutoff);
-			m_forward_shader.set(fmt::format_view("lights{}.max_distance", index), light.max_distance);
-			m_forward_shader.set(fmt::format_view("lights{}.type", index), (int)light.type);
-		}
+	const auto pv = m_active_camera->calculate_pv();
 
-		m_forward_shader.set(fmt::format("lights{}.enabled", index), light.enabled);
+	// includes freed slots, those are skipped through in_use
+	const auto render_data_count = m_render_data.get_slot_count();
+
+	// indexed by render data slot so every job can write its own range without knowing what came before it
+	auto *objects = (OglObject*)m_object_buffer.begin_frame(render_data_count * sizeof(OglObject));
+
+	if (m_object_buffer.is_recreated())
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OGL_OBJECT_BUFFER_BINDING, m_object_buffer.get_buffer());
 	}
 
-	m_forward_shader.set("view_position", m_active_camera->position);
+	const auto first_object = (u32)(m_object_buffer.get_frame_offset() / sizeof(OglObject));
 
-	const auto pv = m_active_camera->calculate_pv();
+	const auto frustum = Frustum::from_matrix(pv);
 
-	for (const auto &data : m_render_data.get_iterator<RenderData>())
+	m_world_bounds.resize(render_data_count);
+	m_in_frustum.resize(render_data_count);
+
+	std::atomic<u32> culled_objects = 0;
+
+	// culling and the object data do not touch gl so they can be spread over the job system ahead of the draw loop
+	parallel_for(m_job_system, render_data_count, OGL_PREPARE_BATCH_SIZE, [&](size_t first, size_t last)
 	{
-		if (data.in_use && data.object.flags & R_VISIBLE)
+		for (auto i = first; i < last; i++)
 		{
-			const auto pvm = pv * data.object.model;
+			const auto *data = m_render_data.get_from_index<RenderData>(i);
 
-			m_forward_shader.set("pvm", pvm);
-			m_forward_shader.set("model", data.object.model);
-			m_forward_shader.set("normal_matrix", data.object.normal_matrix);
+			// freed slots keep whatever was there before, their results are ignored below
+			if (data->in_use)
+			{
+				m_world_bounds.set(i, data->bounds, data->object.model);
+			}
+		}
+
+		cull_bounds(frustum, m_world_bounds, m_in_frustum.data(), first, last);
 
-			auto &material = data.object.material;
+		u32 culled = 0;
 
-			m_forward_shader.set("material.color", material.color);
+		for (auto i = first; i < last; i++)
+		{
+			auto *data = m_render_data.get_from_index<RenderData>(i);
 
-			for (auto i = 0; auto &texture : material.textures)
+			if (!data->in_use || !(data->object.flags & R_VISIBLE))
 			{
-				auto &texture_data = data.textures[i];
+				continue;
+			}
+
+			if (!m_in_frustum[i])
+			{
+				data->object.flags |= R_IS_CULLED;
+				culled++;
 
-				texture_data.bind(i);
+				continue;
+			}
 
-				// Anisotropic filtering
-				// TODO: add global settings for this and add a per mesh override
-				glTexParameterf(texture_data.target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16);
+			data->object.flags &= ~R_IS_CULLED;
 
-				auto &props = g_material_prop_str[i];
+			const auto &material = data->object.material;
 
-				auto enable_texture = texture.enabled;
+			OglObject object;
 
-				m_forward_shader.set(props[1], enable_texture);
+			object.pvm = pv * data->object.model;
+			object.model = data->object.model;
+			object.normal_matrix = data->object.normal_matrix;
+			object.color = glm::vec4(material.color, 1);
 
-				m_forward_shader.set(props[0], i);
-				m_forward_shader.set(props[2], texture.scale);
-				m_forward_shader.set(props[3], texture.strength);
+			for (size_t type = 0; type < TextureType::Max; type++)
+			{
+				const auto &texture = material.textures[type];
 
-				i++;
+				object.textures[type] = glm::vec4(texture.enabled, texture.scale, texture.strength, 0);
 			}
 
-			data.buffers.bind();
+			// written in one go, the mapping is write combined
+			objects[i] = object;
+		}
+
+		culled_objects += culled;
+	});
+
+	m_statistics.culled_objects = culled_objects;
+
+	struct DrawBatch
+	{
+		const RenderData *data;
+		u32 first_command;
+		u32 command_count;
+	};
+
+	FrameArray<OglDrawElementsIndirectCommand> draw_commands;
+	FrameArray<DrawBatch> batches;
+
+	for (size_t render_data_index = 0; render_data_index < render_data_count; render_data_index++)
+	{
+		const auto &data = *m_render_data.get_from_index<RenderData>(render_data_index);
+
+		if (!data.in_use || !(data.object.flags & R_VISIBLE) || data.object.flags & R_IS_CULLED || data.draw_commands.empty())
+		{
+			continue;
+		}
 
-			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, data.draw_command);
+		if (batches.empty() || !can_batch(*batches.back().data, data))
+		{
+			batches.push_back({&data, (u32)draw_commands.size(), 0});
+		}
 
-			glMultiDrawElementsIndirect(
-				GL_TRIANGLES,
-				GL_UNSIGNED_INT,
-				nullptr,
-				data.command_count,
-				0
-			);
+		batches.back().command_count += data.draw_commands.size();
 
-			data.buffers.unbind();
+		for (auto command : data.draw_commands)
+		{
+			command.base_instance = first_object + render_data_index;
 
-			m_statistics.draw_calls++;
+			draw_commands.push_back(command);
 		}
 	}
+
+	auto *mapped_commands = m_draw_command_buffer.begin_frame(draw_commands.size() * sizeof(OglDrawElementsIndirectCommand));
+
+	if (!draw_commands.empty())
+	{
+		std::memcpy(mapped_commands, draw_commands.data(), draw_commands.size() * sizeof(OglDrawElementsIndirectCommand));
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command_buffer.get_buffer());
+
+	m_geometry.bind();
+
+	for (const auto &batch : batches)
+	{
+		for (u32 i = 0; i < TextureType::Max; i++)
+		{
+			auto &texture_data = batch.data->textures[i];
+
+			texture_data.bind(i);
+
+			// Anisotropic filtering
+			// TODO: add global settings for this and add a per mesh override
+			glTexParameterf(texture_data.target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16);
+		}
+
+		const auto offset = m_draw_command_buffer.get_frame_offset() + batch.first_command * sizeof(OglDrawElementsIndirectCommand);
+
+		glMultiDrawElementsIndirect(
+			GL_TRIANGLES,
+			GL_UNSIGNED_INT,
+			(const void*)offset,
+			batch.command_count,
+			0
+		);
+
+		m_statistics.draw_calls++;
+	}
+
+	glBindVertexArray(0);
+
+	m_light_buffer.end_frame();
+	m_object_buffer.end_frame();
+	m_draw_command_buffer.end_frame();
 }
 
 void forge::OglRenderer::shutdown()
 {
 	m_render_data.destroy();
+
+	m_light_buffer.destroy();
+	m_object_buffer.destroy();
+	m_draw_command_buffer.destroy();
+	m_geometry.destroy();
 }
 
 std::vector<forge::DependencyStorage> forge::OglRenderer::get_dependencies()
@@ -298,9 +376,16 @@ forge::RenderObjectTree forge::OglRenderer::create_node_buffers(MeshLoaderNode &
 		out.light = node.light;
 	}
 
-	Array<OglDrawElementsIndirectCommand> draw_commands;
+	auto [rd, id] = m_render_data.emplace<RenderData>();
+
+	if (rd == nullptr)
+	{
+		return out;
+	}
+
+	rd->geometry = m_geometry.allocate(node.mesh.vertices, node.mesh.indices);
 
-	draw_commands.reserve(node.mesh.submeshes.size());
+	rd->draw_commands.reserve(node.mesh.submeshes.size());
 
 	for (auto &submesh : node.mesh.submeshes)
 	{
@@ -308,20 +393,12 @@ forge::RenderObjectTree forge::OglRenderer::create_node_buffers(MeshLoaderNode &
 
 		cmd.count = submesh.index_count;
 		cmd.instance_count = 1;
-		cmd.first_index = submesh.index_offset;
-		cmd.base_instance = submesh.material_index;
+		cmd.first_index = rd->geometry.first_index + submesh.index_offset;
+		cmd.base_vertex = rd->geometry.first_vertex;
 
-		draw_commands.push_back(cmd);
+		rd->draw_commands.push_back(cmd);
 	}
 
-	auto [rd, id] = m_render_data.emplace<RenderData>();
-
-	rd->command_count = draw_commands.size();
-
-	glGenBuffers(1, &rd->draw_command);
-	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rd->draw_command);
-	glBufferData(GL_DRAW_INDIRECT_BUFFER, rd->command_count * sizeof(OglDrawElementsIndirectCommand), draw_commands.data(), GL_STATIC_DRAW);
-
 	rd->object.id = id;
 	rd->object.flags = R_DEFAULT;
 	rd->in_use = true;
@@ -333,16 +410,7 @@ forge::RenderObjectTree forge::OglRenderer::create_node_buffers(MeshLoaderNode &
 	rd->textures[TextureType::Diffuse].load(node.texture);
 	node.texture.unload();
 	rd->index_size = node.mesh.indices.size();
-
-	rd->buffers = OglBufferBuilder()
-		.start()
-		.stride<Vertex>()
-		.vbo(node.mesh.vertices)
-		.ebo(node.mesh.indices)
-		.attr(3)
-		.attr(2)
-		.attr(3)
-		.finish();
+	rd->bounds = node.mesh.bounds.is_empty() ? compute_extents(node.mesh.vertices) : node.mesh.bounds;
 
 	for (auto &child : node.children)
 	{
@@ -370,21 +438,26 @@ forge::RenderObject* forge::OglRenderer::create_render_object(const MeshView &me
 {
 	auto [rd, id] = m_render_data.emplace<RenderData>();
 
+	if (rd == nullptr)
+	{
+		return nullptr;
+	}
+
 	rd->object.id = id;
 	rd->object.flags = R_DEFAULT;
 	rd->in_use = true;
 
 	rd->index_size = mesh.indices.size;
+	rd->bounds = mesh.bounds.is_empty() ? compute_extents(mesh.vertices) : mesh.bounds;
+
+	rd->geometry = m_geometry.allocate(mesh.vertices, mesh.indices);
 
-	rd->buffers = OglBufferBuilder()
-		.start()
-		.stride<Vertex>()
-		.vbo(mesh.vertices)
-		.ebo(mesh.indices)
-		.attr(3)
-		.attr(2)
-		.attr(3)
-		.finish();
+	rd->draw_commands.push_back({
+		.count = rd->geometry.index_count,
+		.instance_count = 1,
+		.first_index = rd->geometry.first_index,
+		.base_vertex = rd->geometry.first_vertex,
+	});
 
 	return &rd->object;
 }
@@ -395,6 +468,7 @@ void forge::OglRenderer::destroy_render_object(RenderObject *object)
 
 	rd->in_use = false;
 
+	m_geometry.free(rd->geometry);
 	m_render_data.free(object->id);
 }
 
@@ -456,9 +530,9 @@ void forge::OglRenderer::destroy_light(Light *light)
 	light->enabled = false;
 }
 
-forge::Array<forge::Light*> forge::OglRenderer::get_active_lights()
+forge::FrameArray<forge::Light*> forge::OglRenderer::get_active_lights()
 {
-	Array<Light*> out;
+	FrameArray<Light*> out;
 
 	out.reserve(OGL_MAX_LIGHTS);
 
@@ -483,3 +557,69 @@ void forge::OglRenderer::handle_framebuffer_resize(int width, int height)
 
 
 
+
+void forge::OglRenderer::init_forward_uniforms()
+{
+	auto &uniforms = m_forward_uniforms;
+
+	uniforms.view_position = m_forward_shader.get_uniform("view_position");
+
+	for (size_t i = 0; i < uniforms.material_textures.size(); i++)
+	{
+		uniforms.material_textures[i] = m_forward_shader.get_uniform(g_material_texture_str[i]);
+	}
+}
+
+void forge::OglRenderer::upload_lights()
+{
+	// the shader stops at the highest enabled light, nothing past it has to be written
+	u32 count = OGL_MAX_LIGHTS;
+
+	while (count > 0 && !m_lights[count - 1].enabled)
+	{
+		count--;
+	}
+
+	auto *buffer = (OglLightBuffer*)m_light_buffer.begin_frame(sizeof(OglLightBuffer));
+
+	buffer->count = count;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		const auto &light = m_lights[i];
+
+		OglLight packed {};
+
+		// the region still holds the lights of an older frame, so disabled ones have to be written as well
+		if (light.enabled)
+		{
+			packed.position = light.position;
+			packed.max_distance = light.max_distance;
+			packed.direction = light.direction;
+			packed.cutoff = light.cutoff;
+			packed.color = light.color;
+			packed.intensity = light.intensity;
+			packed.outer_cutoff = light.outer_cutoff;
+			packed.type = (i32)light.type;
+			packed.enabled = 1;
+		}
+
+		buffer->lights[i] = packed;
+	}
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OGL_LIGHT_BUFFER_BINDING, m_light_buffer.get_buffer(),
+		m_light_buffer.get_frame_offset(), sizeof(OglLightBuffer));
+}
+
+bool forge::OglRenderer::can_batch(const RenderData &first, const RenderData &second)
+{
+	for (size_t i = 0; i < TextureType::Max; i++)
+	{
+		if (first.textures[i].id != second.textures[i].id)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -3,29 +3,38 @@
 #include <functional>
 
 #include "ogl_buffers.hpp"
+#include "ogl_geometry_heap.hpp"
 #include "ogl_shader.hpp"
+#include "ogl_stream_buffer.hpp"
 #include "ogl_texture.hpp"
 #include "render_resource.hpp"
 #include "forge/concurrency/command_buffer.hpp"
 #include "forge/container/array.hpp"
 #include "forge/container/string.hpp"
 #include "forge/core/isub_system.hpp"
+#include "../../math/frustum.hpp"
 #include "../../math/transform.hpp"
 #include "forge/graphics/camera.hpp"
 #include "forge/graphics/lights.hpp"
 #include "forge/graphics/material.hpp"
 #include "forge/graphics/mesh.hpp"
 #include "forge/graphics/loaders/mesh_loader.hpp"
+#include "forge/memory/frame_arena.hpp"
 #include "forge/memory/mem_pool.hpp"
 #include "forge/graphics/render_object.hpp"
 
 class GLFWwindow;
 
-#define OGL_MAX_LIGHTS 16
+#define OGL_MAX_LIGHTS 256
+// shader storage binding of the light buffer, has to match forward_lighting.frag
+#define OGL_LIGHT_BUFFER_BINDING 0
+// shader storage binding of the per object buffer, has to match both forward_lighting shaders
+#define OGL_OBJECT_BUFFER_BINDING 1
 
 namespace forge
 {
 	struct MeshLoaderNode;
+	class JobSystem;
 
 	struct OglRendererArgConfig
 	{
@@ -35,10 +44,21 @@ namespace forge
 	struct RenderStatistics
 	{
 		u32 draw_calls;
+		// objects that were visible but outside of the camera frustum
+		u32 culled_objects;
 	};
 
 	class OglRenderer;
 
+	struct OglDrawElementsIndirectCommand
+	{
+		u32 count			{};
+		u32 instance_count	{};
+		u32 first_index		{};
+		u32 base_vertex		{};
+		u32 base_instance	{};
+	};
+
 	constexpr u8 R_VISIBLE		= 1 << 0;
 	constexpr u8 R_CAST_SHADOW	= 1 << 1;
 	constexpr u8 R_WIREFRAME	= 1 << 2;
@@ -93,17 +113,18 @@ namespace forge
 
 		bool create_texture(RenderObject *object, std::string_view path, u32 type, TextureOptions options = {});
 
-		// allows for manually adding a command that will be run the next frame
-		void add_command(CommandBuffer<>::Callback &&command)
+		// allows for manually adding a command that will be run the next frame. safe to call from any thread
+		template<class Fn>
+		void add_command(Fn &&command)
 		{
-			m_command_buffer.emplace(std::forward<CommandBuffer<>::Callback>(command));
+			m_command_buffer.emplace(std::forward<Fn>(command));
 		}
 
 		Light* create_light();
 
 		void destroy_light(Light *light);
 
-		Array<Light*> get_active_lights();
+		FrameArray<Light*> get_active_lights();
 
 	private:
 		bool m_draw_wireframe = false;
@@ -119,10 +140,10 @@ namespace forge
 		Camera m_default_camera;
 		Camera *m_active_camera = nullptr;
 
-		Material *m_material_ubo = nullptr;
-
 		MemPool m_render_data;
 
+		JobSystem *m_job_system = nullptr;
+
 		struct TextureData
 		{
 			OglTexture texture;
@@ -130,18 +151,89 @@ namespace forge
 			bool is_valid = false;
 		};
 
+		// std430 layout of a light in the light buffer, the scalars fill the padding after each vec3
+		struct OglLight
+		{
+			glm::vec3 position;
+			float max_distance;
+			glm::vec3 direction;
+			float cutoff;
+			glm::vec3 color;
+			float intensity;
+			float outer_cutoff;
+			i32 type;
+			i32 enabled;
+			i32 padding;
+		};
+
+		static_assert(sizeof(OglLight) == 64, "OglLight does not match the std430 layout of Light in the shader");
+
+		struct OglLightBuffer
+		{
+			// one past the highest enabled light, the shader does not look any further
+			u32 count;
+			u32 padding[3];
+			OglLight lights[OGL_MAX_LIGHTS];
+		};
+
+		// rewritten every frame up to the highest enabled light. a region is only written once the gpu is done
+		// with the frame that last read it, so a frame never sees half written lights
+		OglStreamBuffer m_light_buffer;
+
+		// looked up once after the forward shader is compiled so the draw loop never sets uniforms by name
+		struct ForwardUniforms
+		{
+			UniformHandle view_position;
+			TextureList<UniformHandle> material_textures;
+		};
+
+		// std430 layout of an object in the object buffer. the shaders find it through the base_instance of its draws
+		struct OglObject
+		{
+			glm::mat4 pvm;
+			glm::mat4 model;
+			glm::mat4 normal_matrix;
+			glm::vec4 color;
+			// x = enabled, y = scale, z = strength
+			TextureList<glm::vec4> textures;
+		};
+
+		static_assert(sizeof(OglObject) == 256, "OglObject does not match the std430 layout of Object in the shaders");
+
+		// world space bounds and the frustum test result of every render data slot, filled in every frame
+		BoundsSoA m_world_bounds;
+		Array<u8> m_in_frustum;
+
+		// vertices and indices of every render object
+		OglGeometryHeap m_geometry;
+
+		// one object per render data slot, rewritten every frame
+		OglStreamBuffer m_object_buffer;
+		// the draw commands of every visible object, rewritten every frame
+		OglStreamBuffer m_draw_command_buffer;
+
+		ForwardUniforms m_forward_uniforms;
+
 		struct RenderData
 		{
 			RenderObject object;
 			TextureList<OglTexture> textures;
-			OglBuffers buffers;
-			u32 draw_command {};
-			u32 command_count {};
+			OglGeometryAllocation geometry;
+			// local space bounds of the mesh, used for frustum culling
+			Extents bounds;
+			// copied into the command buffer every frame with base_instance pointing at the object
+			Array<OglDrawElementsIndirectCommand> draw_commands;
 			u32 index_size {};
 			bool in_use = true;
 		};
 
 		void handle_framebuffer_resize(int width, int height);
+		void init_forward_uniforms();
+		void upload_lights();
+
+		// objects next to each other in the command buffer can be drawn with one call if they share their textures
+		[[nodiscard]]
+		static bool can_batch(const RenderData &first, const RenderData &second);
 		RenderObjectTree create_node_buffers(MeshLoaderNode &node);
 	};
 
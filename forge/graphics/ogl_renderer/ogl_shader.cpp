@@ -31,10 +31,8 @@ uint32_t ext_to_shader_type(const std::filesystem::path &path)
 	return GL_NONE;
 }
 
-void set_uniform(uint32_t program, std::string_view name, const forge::UniformValue &value)
+void set_uniform(i32 location, const forge::UniformValue &value)
 {
-	auto location = glGetUniformLocation(program, name.data());
-
 	std::visit(util::overload
 	{
 		[location](int value)
@@ -91,9 +89,12 @@ bool forge::OglShader::compile(const ShaderSource &source)
 
 					glUseProgram(m_program);
 
-					for (auto &[name, value] : m_cache)
+					for (u32 i = 0; i < m_cache.size(); i++)
 					{
-						set_uniform(m_program, name, value);
+						if (m_cache[i].has_value() && m_uniform_locations[i] >= 0)
+						{
+							set_uniform(m_uniform_locations[i], *m_cache[i]);
+						}
 					}
 
 					log::info("reloaded shader at path {}", path.c_str());
@@ -132,97 +133,118 @@ forge::OglShader& forge::OglShader::use()
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, int value)
+forge::UniformHandle forge::OglShader::get_uniform(std::string_view name)
 {
+	auto iter = m_uniform_table.find(name);
 
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (iter != m_uniform_table.end())
 	{
-		return *this;
+		return iter->second;
 	}
+
+	// not active in the current program, keep the handle around in case a reload brings it back
+	UniformHandle handle {(u32)m_uniform_locations.size()};
+
+	m_uniform_table.emplace(name, handle);
+	m_uniform_locations.emplace_back(-1);
+
+#if SHOULD_USE_UNIFORM_CACHE
+	m_cache.emplace_back();
 #endif
 
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniform1i(location, value);
+	return handle;
+}
+
+forge::OglShader& forge::OglShader::set(UniformHandle handle, int value)
+{
+	if (auto location = get_location(handle, value); location >= 0)
+	{
+		glUniform1i(location, value);
+	}
 
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, float value)
+forge::OglShader& forge::OglShader::set(UniformHandle handle, float value)
 {
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (auto location = get_location(handle, value); location >= 0)
 	{
-		return *this;
+		glUniform1f(location, value);
 	}
-#endif
-
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniform1f(location, value);
 
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec2 value)
+forge::OglShader& forge::OglShader::set(UniformHandle handle, glm::vec2 value)
 {
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (auto location = get_location(handle, value); location >= 0)
 	{
-		return *this;
+		glUniform2f(location, EXPAND_VEC2(value));
 	}
-#endif
-
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniform2f(location, EXPAND_VEC2(value));
 
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec3 value)
+forge::OglShader& forge::OglShader::set(UniformHandle handle, glm::vec3 value)
 {
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (auto location = get_location(handle, value); location >= 0)
 	{
-		return *this;
+		glUniform3f(location, EXPAND_VEC3(value));
 	}
-#endif
-
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniform3f(location, EXPAND_VEC3(value));
 
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec4 value)
+forge::OglShader& forge::OglShader::set(UniformHandle handle, glm::vec4 value)
 {
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (auto location = get_location(handle, value); location >= 0)
 	{
-		return *this;
+		glUniform4f(location, EXPAND_VEC4(value));
 	}
-#endif
-
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniform4f(location, EXPAND_VEC4(value));
 
 	return *this;
 }
 
-forge::OglShader& forge::OglShader::set(std::string_view name, glm::mat4 value)
+forge::OglShader& forge::OglShader::set(UniformHandle handle, glm::mat4 value)
 {
-#if SHOULD_USE_UNIFORM_CACHE
-	if (update_cache(name, value))
+	if (auto location = get_location(handle, value); location >= 0)
 	{
-		return *this;
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 	}
-#endif
-
-	auto location = glGetUniformLocation(m_program, name.data());
-	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 
 	return *this;
 }
 
+forge::OglShader& forge::OglShader::set(std::string_view name, int value)
+{
+	return set(get_uniform(name), value);
+}
+
+forge::OglShader& forge::OglShader::set(std::string_view name, float value)
+{
+	return set(get_uniform(name), value);
+}
+
+forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec2 value)
+{
+	return set(get_uniform(name), value);
+}
+
+forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec3 value)
+{
+	return set(get_uniform(name), value);
+}
+
+forge::OglShader& forge::OglShader::set(std::string_view name, glm::vec4 value)
+{
+	return set(get_uniform(name), value);
+}
+
+forge::OglShader& forge::OglShader::set(std::string_view name, glm::mat4 value)
+{
+	return set(get_uniform(name), value);
+}
+
 struct ShaderParser
 {
 	const std::string &source;
@@ -425,5 +447,67 @@ bool forge::OglShader::compile_implementation(const ShaderSource &source)
 		return false;
 	}
 
+	reflect_uniforms();
+
 	return true;
 }
+
+void forge::OglShader::reflect_uniforms()
+{
+	// handles that were given out before a reload keep their index, only their location changes
+	std::fill(m_uniform_locations.begin(), m_uniform_locations.end(), -1);
+
+	i32 uniform_count = 0;
+	i32 max_name_length = 0;
+
+	glGetProgramInterfaceiv(m_program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
+	glGetProgramInterfaceiv(m_program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+
+	std::string name;
+
+	name.resize(max_name_length);
+
+	static constexpr GLenum properties[] = {GL_LOCATION, GL_ARRAY_SIZE};
+
+	for (i32 i = 0; i < uniform_count; i++)
+	{
+		i32 values[std::size(properties)];
+
+		glGetProgramResourceiv(m_program, GL_UNIFORM, i, std::size(properties), properties, std::size(values), nullptr, values);
+
+		auto [location, array_size] = values;
+
+		// uniforms inside blocks have no location and are set through their buffer
+		if (location < 0)
+		{
+			continue;
+		}
+
+		i32 length = 0;
+
+		glGetProgramResourceName(m_program, GL_UNIFORM, i, max_name_length, &length, name.data());
+
+		std::string_view view {name.data(), (size_t)length};
+
+		auto handle = get_uniform(view);
+
+		m_uniform_locations[handle.index] = location;
+
+		// arrays of plain types are reported once as name[0], the elements after it have consecutive locations
+		if (array_size > 1 && view.ends_with("[0]"))
+		{
+			view.remove_suffix(3);
+
+			handle = get_uniform(view);
+
+			m_uniform_locations[handle.index] = location;
+
+			for (i32 element = 1; element < array_size; element++)
+			{
+				handle = get_uniform(fmt::format("{}[{}]", view, element));
+
+				m_uniform_locations[handle.index] = location + element;
+			}
+		}
+	}
+}
@@ -4,8 +4,10 @@
 #include <cstdint>
 #include <filesystem>
 #include <mutex>
+#include <optional>
 #include <variant>
 
+#include "forge/container/array.hpp"
 #include "forge/container/map.hpp"
 #include "forge/core/forge_intrinsic.hpp"
 #include "glm/glm.hpp"
@@ -24,6 +26,21 @@ namespace forge
 	using ShaderSource = std::array<std::filesystem::path, SHADER_TYPE_COUNT>;
 	using UniformValue = std::variant<int, float, glm::vec2, glm::vec3, glm::vec4, glm::mat4>;
 
+	constexpr u32 INVALID_UNIFORM_HANDLE = ~u32{0};
+
+	// refers to a uniform by index instead of by name. handles are handed out by OglShader::get_uniform and stay valid
+	// for the lifetime of the shader, including across hot reloads
+	struct UniformHandle
+	{
+		u32 index = INVALID_UNIFORM_HANDLE;
+
+		[[nodiscard]]
+		inline bool is_valid() const
+		{
+			return index != INVALID_UNIFORM_HANDLE;
+		}
+	};
+
 	class OglShader
 	{
 	public:
@@ -40,6 +57,18 @@ namespace forge
 			return m_program;
 		}
 
+		// looks the uniform up once so it can be set without going through its name every time.
+		// uniforms the compiler optimized out still get a handle, setting them does nothing
+		[[nodiscard]]
+		UniformHandle get_uniform(std::string_view name);
+
+		OglShader& set(UniformHandle handle, int value);
+		OglShader& set(UniformHandle handle, float value);
+		OglShader& set(UniformHandle handle, glm::vec2 value);
+		OglShader& set(UniformHandle handle, glm::vec3 value);
+		OglShader& set(UniformHandle handle, glm::vec4 value);
+		OglShader& set(UniformHandle handle, glm::mat4 value);
+
         OglShader& set(std::string_view name, int value);
         OglShader& set(std::string_view name, float value);
         OglShader& set(std::string_view name, glm::vec2 value);
@@ -54,33 +83,43 @@ namespace forge
 		ShaderSource m_source;
 #endif
 
+		// uniform name -> handle, filled in from the program interface after every link
+		HashMap<std::string, UniformHandle, ENABLE_TRANSPARENT_HASH> m_uniform_table;
+		// handle -> location in the current program, -1 for uniforms that are not active
+		Array<i32> m_uniform_locations;
+
 #if SHOULD_USE_UNIFORM_CACHE
-		HashMap<std::string, UniformValue, ENABLE_TRANSPARENT_HASH> m_cache;
+		// handle -> last value that was set, used to skip redundant updates and to restore uniforms on reload
+		Array<std::optional<UniformValue>> m_cache;
 #endif
 
 		uint32_t m_program;
 
 		bool compile_implementation(const ShaderSource &source);
 
-#if SHOULD_USE_UNIFORM_CACHE
+		void reflect_uniforms();
+
 		template<class T>
-		bool update_cache(std::string_view name, T &value)
+		inline i32 get_location(UniformHandle handle, T &value)
 		{
-			auto iter = m_cache.find(name);
+			if (!handle.is_valid())
+			{
+				return -1;
+			}
+
+#if SHOULD_USE_UNIFORM_CACHE
+			auto &cached = m_cache[handle.index];
 
-			if (iter != m_cache.end())
+			if (cached.has_value() && std::get<T>(*cached) == value)
 			{
-				if (std::get<T>(iter->second) == value)
-				{
-					return true;
-				}
+				return -1;
 			}
 
-			m_cache[name] = value;
+			cached = value;
+#endif
 
-			return false;
+			return m_uniform_locations[handle.index];
 		}
-#endif
 
 	};
 }
@@ -0,0 +1,92 @@
+#include "ogl_stream_buffer.hpp"
+
+#include <algorithm>
+
+#include "forge/memory/mem_utils.hpp"
+
+// the region size is rounded up to this so every region starts at an offset usable for any binding
+#define OGL_STREAM_BUFFER_ALIGNMENT 256
+
+forge::OglStreamBuffer::~OglStreamBuffer()
+{
+	destroy();
+}
+
+void forge::OglStreamBuffer::init(u32 target, size_t frame_size)
+{
+	m_target = target;
+	m_frame_size = align_to(std::max<size_t>(frame_size, 1), OGL_STREAM_BUFFER_ALIGNMENT);
+	m_frame = 0;
+
+	const auto size = m_frame_size * OGL_FRAMES_IN_FLIGHT;
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(m_target, m_buffer);
+
+	glBufferStorage(m_target, size, nullptr,
+		GL_MAP_WRITE_BIT |
+		GL_MAP_PERSISTENT_BIT |
+		GL_MAP_COHERENT_BIT);
+
+	m_memory = (u8*)glMapBufferRange(m_target, 0, size,
+		GL_MAP_WRITE_BIT |
+		GL_MAP_PERSISTENT_BIT |
+		GL_MAP_COHERENT_BIT);
+}
+
+void forge::OglStreamBuffer::destroy()
+{
+	for (auto &fence : m_fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (m_buffer != 0)
+	{
+		// gl keeps the storage alive until the commands still reading from it are done
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	m_buffer = 0;
+	m_memory = nullptr;
+}
+
+u8* forge::OglStreamBuffer::begin_frame(size_t size)
+{
+	m_is_recreated = false;
+
+	if (size > m_frame_size)
+	{
+		destroy();
+		init(m_target, std::max(size, m_frame_size * 2));
+
+		m_is_recreated = true;
+	}
+
+	if (auto &fence = m_fences[m_frame]; fence != nullptr)
+	{
+		auto flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+		while (glClientWaitSync(fence, flags, UINT64_MAX) == GL_TIMEOUT_EXPIRED)
+		{
+			flags = 0;
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	return m_memory + get_frame_offset();
+}
+
+void forge::OglStreamBuffer::end_frame()
+{
+	m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_frame = (m_frame + 1) % OGL_FRAMES_IN_FLIGHT;
+}
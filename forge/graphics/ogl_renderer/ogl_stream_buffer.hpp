@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+
+#include "glad/glad.h"
+#include "forge/core/forge_intrinsic.hpp"
+
+// how many frames the cpu may write ahead of the gpu, every frame gets its own region of the buffer
+#define OGL_FRAMES_IN_FLIGHT 3
+
+namespace forge
+{
+	// a persistently mapped buffer for data that is rewritten every frame. it is split into one region per frame in
+	// flight, each guarded by a fence so the cpu never writes to a region the gpu is still reading from
+	class OglStreamBuffer
+	{
+	public:
+		OglStreamBuffer() = default;
+		~OglStreamBuffer();
+
+		OglStreamBuffer(const OglStreamBuffer &) = delete;
+		OglStreamBuffer& operator=(const OglStreamBuffer &) = delete;
+
+		void init(u32 target, size_t frame_size);
+		void destroy();
+
+		// waits for the gpu to be done with the next region and returns it. the buffer is recreated if the region is
+		// smaller than size, so is_recreated has to be checked for bindings that have to be updated
+		u8* begin_frame(size_t size);
+
+		// fences the region written since begin_frame, has to be called after the last command that reads from it
+		void end_frame();
+
+		// offset of the current region from the start of the buffer
+		[[nodiscard]]
+		inline size_t get_frame_offset() const
+		{
+			return m_frame * m_frame_size;
+		}
+
+		[[nodiscard]]
+		inline u32 get_buffer() const
+		{
+			return m_buffer;
+		}
+
+		// true if the last begin_frame replaced the buffer
+		[[nodiscard]]
+		inline bool is_recreated() const
+		{
+			return m_is_recreated;
+		}
+
+	private:
+		u8 *m_memory = nullptr;
+		size_t m_frame_size = 0;
+		u32 m_target = 0;
+		u32 m_buffer = 0;
+		u32 m_frame = 0;
+		bool m_is_recreated = false;
+
+		std::array<GLsync, OGL_FRAMES_IN_FLIGHT> m_fences {};
+	};
+}
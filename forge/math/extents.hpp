@@ -1,12 +1,46 @@
 #pragma once
 
+#include <limits>
+
+#include "glm/common.hpp"
 #include "glm/vec3.hpp"
 
 namespace forge
 {
+	// an axis aligned box. starts out inverted so the first expand sets both corners
 	struct Extents
 	{
-		glm::vec3 min;
-		glm::vec3 max;
+		glm::vec3 min {std::numeric_limits<f32>::max()};
+		glm::vec3 max {std::numeric_limits<f32>::lowest()};
+
+		inline void expand(glm::vec3 point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		inline void expand(const Extents &other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		[[nodiscard]]
+		inline bool is_empty() const
+		{
+			return min.x > max.x || min.y > max.y || min.z > max.z;
+		}
+
+		[[nodiscard]]
+		inline glm::vec3 get_center() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		[[nodiscard]]
+		inline glm::vec3 get_half_size() const
+		{
+			return (max - min) * 0.5f;
+		}
 	};
 }
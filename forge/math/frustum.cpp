@@ -0,0 +1,185 @@
+#include "frustum.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define FORGE_FRUSTUM_KERNEL_X86
+	#include <immintrin.h>
+#endif
+
+forge::Frustum forge::Frustum::from_matrix(const glm::mat4 &pv)
+{
+	// the rows of a column major matrix
+	const auto row = [&](int r)
+	{
+		return glm::vec4{pv[0][r], pv[1][r], pv[2][r], pv[3][r]};
+	};
+
+	Frustum out;
+
+	out.planes[0] = row(3) + row(0);
+	out.planes[1] = row(3) - row(0);
+	out.planes[2] = row(3) + row(1);
+	out.planes[3] = row(3) - row(1);
+	out.planes[4] = row(3) + row(2);
+	out.planes[5] = row(3) - row(2);
+
+	for (auto &plane : out.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return out;
+}
+
+void forge::BoundsSoA::resize(size_t size)
+{
+	center_x.resize(size);
+	center_y.resize(size);
+	center_z.resize(size);
+	half_size_x.resize(size);
+	half_size_y.resize(size);
+	half_size_z.resize(size);
+}
+
+namespace
+{
+	using namespace forge;
+
+	// a box is outside if it lies entirely behind one of the planes, its distance to the plane plus
+	// the projection of its half size onto the plane normal is below zero
+	void cull_scalar(const Frustum &frustum, const BoundsSoA &bounds, u8 *visible, size_t first, size_t last)
+	{
+		for (auto i = first; i < last; i++)
+		{
+			const glm::vec3 center {bounds.center_x[i], bounds.center_y[i], bounds.center_z[i]};
+			const glm::vec3 half_size {bounds.half_size_x[i], bounds.half_size_y[i], bounds.half_size_z[i]};
+
+			bool is_inside = true;
+
+			for (const auto &plane : frustum.planes)
+			{
+				const auto normal = glm::vec3(plane);
+
+				is_inside &= glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), half_size) >= 0;
+			}
+
+			visible[i] = is_inside;
+		}
+	}
+
+#ifdef FORGE_FRUSTUM_KERNEL_X86
+
+	void cull_sse(const Frustum &frustum, const BoundsSoA &bounds, u8 *visible, size_t first, size_t last)
+	{
+		const auto sign_mask = _mm_set1_ps(-0.0f);
+		const auto zero = _mm_setzero_ps();
+
+		auto i = first;
+
+		for (; i + 4 <= last; i += 4)
+		{
+			const auto center_x = _mm_loadu_ps(&bounds.center_x[i]);
+			const auto center_y = _mm_loadu_ps(&bounds.center_y[i]);
+			const auto center_z = _mm_loadu_ps(&bounds.center_z[i]);
+			const auto half_size_x = _mm_loadu_ps(&bounds.half_size_x[i]);
+			const auto half_size_y = _mm_loadu_ps(&bounds.half_size_y[i]);
+			const auto half_size_z = _mm_loadu_ps(&bounds.half_size_z[i]);
+
+			auto outside = _mm_setzero_ps();
+
+			for (const auto &plane : frustum.planes)
+			{
+				const auto normal_x = _mm_set1_ps(plane.x);
+				const auto normal_y = _mm_set1_ps(plane.y);
+				const auto normal_z = _mm_set1_ps(plane.z);
+
+				auto distance = _mm_add_ps(_mm_mul_ps(normal_x, center_x), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(normal_y, center_y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(normal_z, center_z));
+
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, normal_x), half_size_x));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, normal_y), half_size_y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, normal_z), half_size_z));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+			}
+
+			const auto mask = _mm_movemask_ps(outside);
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				visible[i + lane] = !(mask & (1 << lane));
+			}
+		}
+
+		cull_scalar(frustum, bounds, visible, i, last);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void cull_avx2(const Frustum &frustum, const BoundsSoA &bounds, u8 *visible, size_t first, size_t last)
+	{
+		const auto sign_mask = _mm256_set1_ps(-0.0f);
+		const auto zero = _mm256_setzero_ps();
+
+		auto i = first;
+
+		for (; i + 8 <= last; i += 8)
+		{
+			const auto center_x = _mm256_loadu_ps(&bounds.center_x[i]);
+			const auto center_y = _mm256_loadu_ps(&bounds.center_y[i]);
+			const auto center_z = _mm256_loadu_ps(&bounds.center_z[i]);
+			const auto half_size_x = _mm256_loadu_ps(&bounds.half_size_x[i]);
+			const auto half_size_y = _mm256_loadu_ps(&bounds.half_size_y[i]);
+			const auto half_size_z = _mm256_loadu_ps(&bounds.half_size_z[i]);
+
+			auto outside = _mm256_setzero_ps();
+
+			for (const auto &plane : frustum.planes)
+			{
+				const auto normal_x = _mm256_set1_ps(plane.x);
+				const auto normal_y = _mm256_set1_ps(plane.y);
+				const auto normal_z = _mm256_set1_ps(plane.z);
+
+				auto distance = _mm256_fmadd_ps(normal_x, center_x, _mm256_set1_ps(plane.w));
+				distance = _mm256_fmadd_ps(normal_y, center_y, distance);
+				distance = _mm256_fmadd_ps(normal_z, center_z, distance);
+
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, normal_x), half_size_x, distance);
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, normal_y), half_size_y, distance);
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, normal_z), half_size_z, distance);
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+			}
+
+			const auto mask = _mm256_movemask_ps(outside);
+
+			for (int lane = 0; lane < 8; lane++)
+			{
+				visible[i + lane] = !(mask & (1 << lane));
+			}
+		}
+
+		cull_sse(frustum, bounds, visible, i, last);
+	}
+
+#endif
+}
+
+void forge::cull_bounds(const Frustum &frustum, const BoundsSoA &bounds, u8 *visible, size_t first, size_t last,
+	SimdLevel level)
+{
+#ifdef FORGE_FRUSTUM_KERNEL_X86
+	switch (level)
+	{
+		case SimdLevel::Avx2:
+			cull_avx2(frustum, bounds, visible, first, last);
+			return;
+		case SimdLevel::Sse:
+			cull_sse(frustum, bounds, visible, first, last);
+			return;
+		default:
+			break;
+	}
+#endif
+
+	cull_scalar(frustum, bounds, visible, first, last);
+}
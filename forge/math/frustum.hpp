@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "extents.hpp"
+#include "transform_kernel.hpp"
+#include "forge/container/array.hpp"
+
+namespace forge
+{
+	// the six planes of a projection * view matrix, pointing inwards. xyz is the normal and w the distance
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+
+		[[nodiscard]]
+		static Frustum from_matrix(const glm::mat4 &pv);
+	};
+
+	// world space boxes laid out as one array per component so the culling kernel can test several at once
+	struct BoundsSoA
+	{
+		Array<f32> center_x;
+		Array<f32> center_y;
+		Array<f32> center_z;
+		Array<f32> half_size_x;
+		Array<f32> half_size_y;
+		Array<f32> half_size_z;
+
+		void resize(size_t size);
+
+		[[nodiscard]]
+		inline size_t size() const
+		{
+			return center_x.size();
+		}
+
+		inline void set(size_t index, glm::vec3 center, glm::vec3 half_size)
+		{
+			center_x[index] = center.x;
+			center_y[index] = center.y;
+			center_z[index] = center.z;
+			half_size_x[index] = half_size.x;
+			half_size_y[index] = half_size.y;
+			half_size_z[index] = half_size.z;
+		}
+
+		// the world space box around local space bounds moved by model. empty bounds are never culled
+		inline void set(size_t index, const Extents &bounds, const glm::mat4 &model)
+		{
+			if (bounds.is_empty())
+			{
+				set(index, glm::vec3{0}, glm::vec3{std::numeric_limits<f32>::max()});
+
+				return;
+			}
+
+			const auto half_size = bounds.get_half_size();
+
+			const auto center = glm::vec3(model * glm::vec4(bounds.get_center(), 1));
+			const auto world_half_size = glm::abs(glm::vec3(model[0])) * half_size.x
+				+ glm::abs(glm::vec3(model[1])) * half_size.y
+				+ glm::abs(glm::vec3(model[2])) * half_size.z;
+
+			set(index, center, world_half_size);
+		}
+	};
+
+	// writes 1 to visible for every box in [first, last) that touches the frustum and 0 for the rest.
+	// boxes that are close to a corner of the frustum may be kept even if they are outside of it.
+	// there is no bounding sphere pass first, a plane test against a box costs the same as one against a sphere here
+	void cull_bounds(const Frustum &frustum, const BoundsSoA &bounds, u8 *visible, size_t first, size_t last,
+		SimdLevel level = get_supported_simd_level());
+}
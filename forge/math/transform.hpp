@@ -154,15 +154,25 @@ namespace forge
 			return m_global_matrix;
 		}
 
-		inline glm::mat4 compute_local_transform()
+		// direct write access for code computing global matrices in bulk. the caller has to clear is_dirty itself
+		[[nodiscard]]
+		inline glm::mat4& get_global_matrix_storage()
 		{
-			glm::mat4 identity {1.0f};
+			return m_global_matrix;
+		}
 
-			auto T = glm::translate(identity, m_position);
-			auto R = glm::toMat4(m_rotation);
-			auto S = glm::scale(identity, m_scale);
+		// translation * rotation * scale, composed directly instead of multiplying three matrices
+		inline glm::mat4 compute_local_transform()
+		{
+			const auto rotation = glm::toMat3(m_rotation);
 
-			return T * R * S;
+			return glm::mat4
+			{
+				glm::vec4{rotation[0] * m_scale.x, 0},
+				glm::vec4{rotation[1] * m_scale.y, 0},
+				glm::vec4{rotation[2] * m_scale.z, 0},
+				glm::vec4{m_position, 1},
+			};
 		}
 
 		[[nodiscard]]
@@ -0,0 +1,356 @@
+#include "transform_kernel.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define FORGE_TRANSFORM_KERNEL_X86
+	#include <immintrin.h>
+#endif
+
+forge::SimdLevel forge::get_supported_simd_level()
+{
+#ifdef FORGE_TRANSFORM_KERNEL_X86
+	static const auto level = []
+	{
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return SimdLevel::Avx2;
+		}
+
+		if (__builtin_cpu_supports("sse2"))
+		{
+			return SimdLevel::Sse;
+		}
+
+		return SimdLevel::Scalar;
+	}();
+
+	return level;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+void forge::TransformSoA::resize(size_t size)
+{
+	position_x.resize(size);
+	position_y.resize(size);
+	position_z.resize(size);
+	rotation_x.resize(size);
+	rotation_y.resize(size);
+	rotation_z.resize(size);
+	rotation_w.resize(size);
+	scale_x.resize(size);
+	scale_y.resize(size);
+	scale_z.resize(size);
+}
+
+namespace
+{
+	using namespace forge;
+
+	void compute_scalar(const TransformSoA &in, const glm::mat4 *const *parents, glm::mat4 *const *out,
+		size_t first, size_t last)
+	{
+		for (auto i = first; i < last; i++)
+		{
+			const auto x = in.rotation_x[i];
+			const auto y = in.rotation_y[i];
+			const auto z = in.rotation_z[i];
+			const auto w = in.rotation_w[i];
+
+			const auto sx = in.scale_x[i];
+			const auto sy = in.scale_y[i];
+			const auto sz = in.scale_z[i];
+
+			const glm::mat4 local
+			{
+				glm::vec4{1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0} * sx,
+				glm::vec4{2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0} * sy,
+				glm::vec4{2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0} * sz,
+				glm::vec4{in.position_x[i], in.position_y[i], in.position_z[i], 1},
+			};
+
+			*out[i] = parents[i] ? *parents[i] * local : local;
+		}
+	}
+
+#ifdef FORGE_TRANSFORM_KERNEL_X86
+
+	// the rotation and scale part of four local matrices. element [column][row] holds that entry for all four lanes
+	struct LocalLanes
+	{
+		__m128 m[3][3];
+		__m128 position[3];
+	};
+
+	// turns four lanes of soa results into the columns of four column major matrices, indexed [lane][column].
+	// always inlined so the avx2 path gets a vex encoded copy instead of paying for sse/avx transitions
+	[[gnu::always_inline]]
+	inline void transpose_lanes(const LocalLanes &lanes, __m128 (&columns)[4][4])
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			auto r0 = lanes.m[c][0];
+			auto r1 = lanes.m[c][1];
+			auto r2 = lanes.m[c][2];
+			auto r3 = _mm_setzero_ps();
+
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+			columns[0][c] = r0;
+			columns[1][c] = r1;
+			columns[2][c] = r2;
+			columns[3][c] = r3;
+		}
+
+		auto p0 = lanes.position[0];
+		auto p1 = lanes.position[1];
+		auto p2 = lanes.position[2];
+		auto p3 = _mm_set1_ps(1);
+
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+		columns[0][3] = p0;
+		columns[1][3] = p1;
+		columns[2][3] = p2;
+		columns[3][3] = p3;
+	}
+
+	// applies the parents and writes four lanes out. lanes are finished in order so a lane can use the output
+	// of an earlier lane as its parent
+	void store_lanes(const LocalLanes &lanes, const glm::mat4 *const *parents, glm::mat4 *const *out)
+	{
+		__m128 columns[4][4];
+
+		transpose_lanes(lanes, columns);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			auto *destination = &(*out[lane])[0][0];
+
+			if (parents[lane] == nullptr)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					_mm_storeu_ps(destination + c * 4, columns[lane][c]);
+				}
+
+				continue;
+			}
+
+			const auto *parent = &(*parents[lane])[0][0];
+
+			const auto parent0 = _mm_loadu_ps(parent);
+			const auto parent1 = _mm_loadu_ps(parent + 4);
+			const auto parent2 = _mm_loadu_ps(parent + 8);
+			const auto parent3 = _mm_loadu_ps(parent + 12);
+
+			for (int c = 0; c < 4; c++)
+			{
+				const auto column = columns[lane][c];
+
+				auto result = _mm_mul_ps(parent0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm_add_ps(result, _mm_mul_ps(parent1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+				result = _mm_add_ps(result, _mm_mul_ps(parent2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+				result = _mm_add_ps(result, _mm_mul_ps(parent3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+
+				_mm_storeu_ps(destination + c * 4, result);
+			}
+		}
+	}
+
+	// same as store_lanes but multiplies two columns at a time
+	__attribute__((target("avx2,fma")))
+	void store_lanes_avx2(const LocalLanes &lanes, const glm::mat4 *const *parents, glm::mat4 *const *out)
+	{
+		__m128 columns[4][4];
+
+		transpose_lanes(lanes, columns);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			auto *destination = &(*out[lane])[0][0];
+
+			const auto columns01 = _mm256_set_m128(columns[lane][1], columns[lane][0]);
+			const auto columns23 = _mm256_set_m128(columns[lane][3], columns[lane][2]);
+
+			if (parents[lane] == nullptr)
+			{
+				_mm256_storeu_ps(destination, columns01);
+				_mm256_storeu_ps(destination + 8, columns23);
+
+				continue;
+			}
+
+			const auto *parent = &(*parents[lane])[0][0];
+
+			const auto parent0 = _mm256_broadcast_ps((const __m128*)parent);
+			const auto parent1 = _mm256_broadcast_ps((const __m128*)(parent + 4));
+			const auto parent2 = _mm256_broadcast_ps((const __m128*)(parent + 8));
+			const auto parent3 = _mm256_broadcast_ps((const __m128*)(parent + 12));
+
+			auto result01 = _mm256_mul_ps(parent0, _mm256_permute_ps(columns01, _MM_SHUFFLE(0, 0, 0, 0)));
+			result01 = _mm256_fmadd_ps(parent1, _mm256_permute_ps(columns01, _MM_SHUFFLE(1, 1, 1, 1)), result01);
+			result01 = _mm256_fmadd_ps(parent2, _mm256_permute_ps(columns01, _MM_SHUFFLE(2, 2, 2, 2)), result01);
+			result01 = _mm256_fmadd_ps(parent3, _mm256_permute_ps(columns01, _MM_SHUFFLE(3, 3, 3, 3)), result01);
+
+			auto result23 = _mm256_mul_ps(parent0, _mm256_permute_ps(columns23, _MM_SHUFFLE(0, 0, 0, 0)));
+			result23 = _mm256_fmadd_ps(parent1, _mm256_permute_ps(columns23, _MM_SHUFFLE(1, 1, 1, 1)), result23);
+			result23 = _mm256_fmadd_ps(parent2, _mm256_permute_ps(columns23, _MM_SHUFFLE(2, 2, 2, 2)), result23);
+			result23 = _mm256_fmadd_ps(parent3, _mm256_permute_ps(columns23, _MM_SHUFFLE(3, 3, 3, 3)), result23);
+
+			_mm256_storeu_ps(destination, result01);
+			_mm256_storeu_ps(destination + 8, result23);
+		}
+	}
+
+	void compute_sse(const TransformSoA &in, const glm::mat4 *const *parents, glm::mat4 *const *out,
+		size_t first, size_t last)
+	{
+		const auto one = _mm_set1_ps(1);
+		const auto two = _mm_set1_ps(2);
+
+		auto i = first;
+
+		for (; i + 4 <= last; i += 4)
+		{
+			const auto x = _mm_loadu_ps(&in.rotation_x[i]);
+			const auto y = _mm_loadu_ps(&in.rotation_y[i]);
+			const auto z = _mm_loadu_ps(&in.rotation_z[i]);
+			const auto w = _mm_loadu_ps(&in.rotation_w[i]);
+
+			const auto xx = _mm_mul_ps(x, x);
+			const auto yy = _mm_mul_ps(y, y);
+			const auto zz = _mm_mul_ps(z, z);
+			const auto xy = _mm_mul_ps(x, y);
+			const auto xz = _mm_mul_ps(x, z);
+			const auto yz = _mm_mul_ps(y, z);
+			const auto wx = _mm_mul_ps(w, x);
+			const auto wy = _mm_mul_ps(w, y);
+			const auto wz = _mm_mul_ps(w, z);
+
+			const auto sx = _mm_loadu_ps(&in.scale_x[i]);
+			const auto sy = _mm_loadu_ps(&in.scale_y[i]);
+			const auto sz = _mm_loadu_ps(&in.scale_z[i]);
+
+			LocalLanes lanes;
+
+			lanes.m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+			lanes.m[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+			lanes.m[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+			lanes.m[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+			lanes.m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+			lanes.m[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+			lanes.m[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+			lanes.m[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+			lanes.m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+			lanes.position[0] = _mm_loadu_ps(&in.position_x[i]);
+			lanes.position[1] = _mm_loadu_ps(&in.position_y[i]);
+			lanes.position[2] = _mm_loadu_ps(&in.position_z[i]);
+
+			store_lanes(lanes, parents + i, out + i);
+		}
+
+		compute_scalar(in, parents, out, i, last);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void compute_avx2(const TransformSoA &in, const glm::mat4 *const *parents, glm::mat4 *const *out,
+		size_t first, size_t last)
+	{
+		const auto one = _mm256_set1_ps(1);
+		const auto two = _mm256_set1_ps(2);
+
+		auto i = first;
+
+		for (; i + 8 <= last; i += 8)
+		{
+			const auto x = _mm256_loadu_ps(&in.rotation_x[i]);
+			const auto y = _mm256_loadu_ps(&in.rotation_y[i]);
+			const auto z = _mm256_loadu_ps(&in.rotation_z[i]);
+			const auto w = _mm256_loadu_ps(&in.rotation_w[i]);
+
+			const auto xx = _mm256_mul_ps(x, x);
+			const auto yy = _mm256_mul_ps(y, y);
+			const auto zz = _mm256_mul_ps(z, z);
+			const auto xy = _mm256_mul_ps(x, y);
+			const auto xz = _mm256_mul_ps(x, z);
+			const auto yz = _mm256_mul_ps(y, z);
+			const auto wx = _mm256_mul_ps(w, x);
+			const auto wy = _mm256_mul_ps(w, y);
+			const auto wz = _mm256_mul_ps(w, z);
+
+			const auto sx = _mm256_loadu_ps(&in.scale_x[i]);
+			const auto sy = _mm256_loadu_ps(&in.scale_y[i]);
+			const auto sz = _mm256_loadu_ps(&in.scale_z[i]);
+
+			__m256 m[3][3];
+
+			m[0][0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx);
+			m[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+			m[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+
+			m[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+			m[1][1] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy);
+			m[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+
+			m[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+			m[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+			m[2][2] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz);
+
+			const __m256 position[3]
+			{
+				_mm256_loadu_ps(&in.position_x[i]),
+				_mm256_loadu_ps(&in.position_y[i]),
+				_mm256_loadu_ps(&in.position_z[i]),
+			};
+
+			// the lower half has to be stored first in case the upper half uses it as a parent
+			LocalLanes low;
+			LocalLanes high;
+
+			for (int c = 0; c < 3; c++)
+			{
+				for (int r = 0; r < 3; r++)
+				{
+					low.m[c][r] = _mm256_castps256_ps128(m[c][r]);
+					high.m[c][r] = _mm256_extractf128_ps(m[c][r], 1);
+				}
+
+				low.position[c] = _mm256_castps256_ps128(position[c]);
+				high.position[c] = _mm256_extractf128_ps(position[c], 1);
+			}
+
+			store_lanes_avx2(low, parents + i, out + i);
+			store_lanes_avx2(high, parents + i + 4, out + i + 4);
+		}
+
+		compute_sse(in, parents, out, i, last);
+	}
+
+#endif
+}
+
+void forge::compute_global_matrices(const TransformSoA &transforms, const glm::mat4 *const *parents, glm::mat4 *const *out,
+	size_t first, size_t last, SimdLevel level)
+{
+#ifdef FORGE_TRANSFORM_KERNEL_X86
+	switch (level)
+	{
+		case SimdLevel::Avx2:
+			compute_avx2(transforms, parents, out, first, last);
+			return;
+		case SimdLevel::Sse:
+			compute_sse(transforms, parents, out, first, last);
+			return;
+		default:
+			break;
+	}
+#endif
+
+	compute_scalar(transforms, parents, out, first, last);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "forge/container/array.hpp"
+
+namespace forge
+{
+	enum class SimdLevel
+	{
+		Scalar,
+		Sse,
+		Avx2,
+	};
+
+	// the best instruction set the kernel can use on this cpu. checked once
+	[[nodiscard]]
+	SimdLevel get_supported_simd_level();
+
+	// transforms laid out as one array per component so the kernel can load several of them into one register
+	struct TransformSoA
+	{
+		Array<f32> position_x;
+		Array<f32> position_y;
+		Array<f32> position_z;
+		Array<f32> rotation_x;
+		Array<f32> rotation_y;
+		Array<f32> rotation_z;
+		Array<f32> rotation_w;
+		Array<f32> scale_x;
+		Array<f32> scale_y;
+		Array<f32> scale_z;
+
+		void resize(size_t size);
+
+		[[nodiscard]]
+		inline size_t size() const
+		{
+			return position_x.size();
+		}
+
+		inline void set(size_t index, glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+		{
+			position_x[index] = position.x;
+			position_y[index] = position.y;
+			position_z[index] = position.z;
+			rotation_x[index] = rotation.x;
+			rotation_y[index] = rotation.y;
+			rotation_z[index] = rotation.z;
+			rotation_w[index] = rotation.w;
+			scale_x[index] = scale.x;
+			scale_y[index] = scale.y;
+			scale_z[index] = scale.z;
+		}
+	};
+
+	// composes translation * rotation * scale for the transforms in [first, last) straight from their components and
+	// writes parent * local to out. a null parent means the transform is a root.
+	// results are written in index order, so a parent may be an earlier output of the same call
+	void compute_global_matrices(const TransformSoA &transforms, const glm::mat4 *const *parents, glm::mat4 *const *out,
+		size_t first, size_t last, SimdLevel level = get_supported_simd_level());
+}
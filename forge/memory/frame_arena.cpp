@@ -0,0 +1,89 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include "mem_utils.hpp"
+#include "forge/core/engine.hpp"
+#include "forge/core/logging.hpp"
+#include "forge/system/virtual_memory.hpp"
+
+forge::FrameArena::~FrameArena()
+{
+	if (m_memory)
+	{
+		virtual_free(m_memory);
+		m_memory = nullptr;
+	}
+}
+
+bool forge::FrameArena::init(size_t capacity)
+{
+	m_memory = virtual_reserve(capacity);
+
+	m_offset = 0;
+	m_committed = 0;
+	m_capacity = capacity;
+
+	return m_memory != nullptr;
+}
+
+u8* forge::FrameArena::allocate(size_t size, size_t alignment)
+{
+	// the address has to be aligned, the memory itself only starts on a cache line
+	const auto offset = align_to((size_t)(m_memory + m_offset), alignment) - (size_t)m_memory;
+	const auto end = offset + size;
+
+	if (end > m_capacity)
+	{
+		return allocate_overflow(size, alignment);
+	}
+
+	if (end > m_committed)
+	{
+		const auto committed = std::min(align_to(end, FRAME_ARENA_COMMIT_GRANULARITY), m_capacity);
+
+		if (!virtual_commit(m_memory + m_committed, committed - m_committed))
+		{
+			return allocate_overflow(size, alignment);
+		}
+
+		m_committed = committed;
+	}
+
+	m_offset = end;
+
+	return m_memory + offset;
+}
+
+void forge::FrameArena::free(u8 *ptr, size_t size, size_t alignment)
+{
+	if (!owns(ptr))
+	{
+		::operator delete(ptr, std::align_val_t{alignment});
+		return;
+	}
+
+	if (ptr + size == m_memory + m_offset)
+	{
+		m_offset = ptr - m_memory;
+	}
+}
+
+u8* forge::FrameArena::allocate_overflow(size_t size, size_t alignment)
+{
+	if (!m_has_overflowed)
+	{
+		log::warn("frame arena ran out of memory, falling back to the heap. raise FRAME_ARENA_SIZE");
+		m_has_overflowed = true;
+	}
+
+	return (u8*)::operator new(size, std::align_val_t{alignment});
+}
+
+forge::FrameArena& forge::get_frame_arena()
+{
+	thread_local FrameArena *arena = g_engine.create_frame_arena();
+
+	return *arena;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+
+#include "forge/container/array.hpp"
+#include "forge/memory/defs.hpp"
+#include "forge/util/types.hpp"
+
+// the address space every thread reserves for its frame arena. only what is used gets committed
+#define FRAME_ARENA_SIZE MB(64)
+#define FRAME_ARENA_COMMIT_GRANULARITY KB(64)
+
+namespace forge
+{
+	// a bump allocator for memory that only has to live until the end of the frame. everything allocated from it is
+	// dropped at once by reset, which the engine does between frames. nothing gets freed on its own
+	class FrameArena
+	{
+	public:
+		FrameArena() = default;
+		~FrameArena();
+
+		FrameArena(const FrameArena &) = delete;
+		FrameArena& operator=(const FrameArena &) = delete;
+
+		bool init(size_t capacity = FRAME_ARENA_SIZE);
+
+		// goes to the heap once the arena is full, so this never fails. free has to be called for such allocations
+		u8* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// hands the memory back if it was the last allocation, lets growing arrays reuse their old space.
+		// alignment has to be the one passed to allocate
+		void free(u8 *ptr, size_t size, size_t alignment = alignof(std::max_align_t));
+
+		[[nodiscard]]
+		inline bool owns(const u8 *ptr) const
+		{
+			return ptr >= m_memory && ptr < m_memory + m_capacity;
+		}
+
+		// the committed pages are kept, a frame usually needs as much as the one before it
+		inline void reset()
+		{
+			m_offset = 0;
+		}
+
+		[[nodiscard]]
+		inline size_t get_used() const
+		{
+			return m_offset;
+		}
+
+		[[nodiscard]]
+		inline size_t get_committed_size() const
+		{
+			return m_committed;
+		}
+
+	private:
+		u8 *m_memory = nullptr;
+		size_t m_offset = 0;
+		size_t m_committed = 0;
+		size_t m_capacity = 0;
+		// only warned about once per arena
+		bool m_has_overflowed = false;
+
+		u8* allocate_overflow(size_t size, size_t alignment);
+	};
+
+	// the arena of the calling thread, created the first time a thread asks for it.
+	// the engine resets all of them between frames, so threads that run outside of the frame loop must not use it
+	FrameArena& get_frame_arena();
+
+	// lets standard containers allocate from the frame arena of the calling thread. the containers must not outlive
+	// the frame and have to be destroyed on the thread that allocated them
+	template<class T>
+	struct FrameAllocator
+	{
+		using value_type = T;
+
+		FrameAllocator() = default;
+
+		template<class U>
+		constexpr FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+		static T* allocate(size_t n)
+		{
+			return (T*)get_frame_arena().allocate(n * sizeof(T), alignof(T));
+		}
+
+		static void deallocate(T *p, size_t n) noexcept
+		{
+			get_frame_arena().free((u8*)p, n * sizeof(T), alignof(T));
+		}
+
+		template<class U>
+		bool operator==(const FrameAllocator<U>&) const noexcept
+		{
+			return true;
+		}
+	};
+
+	template<class T>
+	using FrameArray = Array<T, FrameAllocator<T>>;
+
+	using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+}
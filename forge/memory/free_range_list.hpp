@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cassert>
+#include <map>
+#include <optional>
+
+namespace forge
+{
+	// keeps track of freed [first, first + count) ranges of slots, sorted by their first slot.
+	// neighbouring ranges are merged on free so a run of single frees can satisfy a contiguous request later on
+	class FreeRangeList
+	{
+	public:
+		// first fit, takes the slots from the start of the lowest range that is big enough to keep the used slots packed
+		std::optional<size_t> allocate(size_t count)
+		{
+			for (auto iter = m_ranges.begin(); iter != m_ranges.end(); ++iter)
+			{
+				auto [first, length] = *iter;
+
+				if (length < count)
+				{
+					continue;
+				}
+
+				m_ranges.erase(iter);
+
+				if (length > count)
+				{
+					m_ranges.emplace(first + count, length - count);
+				}
+
+				m_free_count -= count;
+
+				return first;
+			}
+
+			return std::nullopt;
+		}
+
+		void free(size_t first, size_t count)
+		{
+			auto next = m_ranges.lower_bound(first);
+
+			assert((next == m_ranges.end() || first + count <= next->first) && "freeing a range that is already free");
+
+			if (next != m_ranges.begin())
+			{
+				auto previous = std::prev(next);
+
+				assert(previous->first + previous->second <= first && "freeing a range that is already free");
+
+				if (previous->first + previous->second == first)
+				{
+					first = previous->first;
+					count += previous->second;
+					m_free_count -= previous->second;
+
+					m_ranges.erase(previous);
+				}
+			}
+
+			if (next != m_ranges.end() && first + count == next->first)
+			{
+				count += next->second;
+				m_free_count -= next->second;
+
+				m_ranges.erase(next);
+			}
+
+			m_ranges.emplace(first, count);
+			m_free_count += count;
+		}
+
+		// removes and returns the range ending at end if there is one, used to give trailing slots back
+		std::optional<std::pair<size_t, size_t>> pop_range_ending_at(size_t end)
+		{
+			if (m_ranges.empty())
+			{
+				return std::nullopt;
+			}
+
+			auto last = std::prev(m_ranges.end());
+
+			if (last->first + last->second != end)
+			{
+				return std::nullopt;
+			}
+
+			auto range = *last;
+
+			m_ranges.erase(last);
+			m_free_count -= range.second;
+
+			return range;
+		}
+
+		void clear()
+		{
+			m_ranges.clear();
+			m_free_count = 0;
+		}
+
+		[[nodiscard]]
+		inline bool empty() const
+		{
+			return m_ranges.empty();
+		}
+
+		// the total amount of free slots across all ranges
+		[[nodiscard]]
+		inline size_t get_free_count() const
+		{
+			return m_free_count;
+		}
+
+		[[nodiscard]]
+		inline size_t get_range_count() const
+		{
+			return m_ranges.size();
+		}
+
+		[[nodiscard]]
+		inline const std::map<size_t, size_t>& get_ranges() const
+		{
+			return m_ranges;
+		}
+
+	private:
+		// first slot -> amount of slots
+		std::map<size_t, size_t> m_ranges;
+		size_t m_free_count = 0;
+	};
+}
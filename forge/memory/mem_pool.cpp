@@ -10,11 +10,19 @@
 #include "forge/system/virtual_memory.hpp"
 #include "forge/system/system_info.hpp"
 
-bool forge::MemPool::init(size_t element_size, size_t map_size)
+bool forge::MemPool::init(size_t element_size, size_t map_size, u8 alloc_flags)
 {
-	m_memory = virtual_alloc(map_size);
+	m_memory = virtual_reserve(map_size, alloc_flags);
+
+	if (m_memory == nullptr)
+	{
+		return false;
+	}
 
 	m_element_size = element_size;
+	m_map_size = map_size;
+	m_committed = 0;
+	m_alloc_flags = alloc_flags;
 	m_offset = 0;
 	m_length = 0;
 
@@ -26,6 +34,38 @@ forge::MemPool::~MemPool()
 	destroy();
 }
 
+forge::MemPool::MemPool(MemPool &&other) noexcept
+{
+	*this = std::move(other);
+}
+
+forge::MemPool& forge::MemPool::operator=(MemPool &&other) noexcept
+{
+	if (this == &other)
+	{
+		return *this;
+	}
+
+	destroy();
+
+	m_memory = std::exchange(other.m_memory, nullptr);
+	m_offset = std::exchange(other.m_offset, 0);
+	m_length = std::exchange(other.m_length, 0);
+	m_element_size = other.m_element_size;
+	m_map_size = other.m_map_size;
+	m_committed = std::exchange(other.m_committed, 0);
+	m_alloc_flags = other.m_alloc_flags;
+	m_free_ranges = std::move(other.m_free_ranges);
+	m_destroy_func = other.m_destroy_func;
+	m_construct_func = other.m_construct_func;
+	m_relocate_func = other.m_relocate_func;
+	m_handle_to_slot = std::move(other.m_handle_to_slot);
+	m_slot_to_handle = std::move(other.m_slot_to_handle);
+	m_free_handles = std::move(other.m_free_handles);
+
+	return *this;
+}
+
 void forge::MemPool::destroy()
 {
 	if (m_memory)
@@ -37,42 +77,53 @@ void forge::MemPool::destroy()
 
 forge::MemPoolObject forge::MemPool::allocate(bool construct)
 {
-	auto offset = m_offset;
+	return allocate(1, construct);
+}
 
-	if (!m_free_list.empty())
+forge::MemPoolObject forge::MemPool::allocate(u32 count, bool construct)
+{
+	size_t offset;
+
+	if (auto first = m_free_ranges.allocate(count))
 	{
-		offset = m_free_list.back();
-		m_free_list.pop_back();
+		offset = *first * m_element_size;
 	}
+	else
+	{
+		const auto end = m_offset + m_element_size * count;
 
-	auto *out_mem = m_memory + offset;
-	auto mem_offset = offset;
+		if (end > m_map_size)
+		{
+			log::fatal("MemPool ran out of mapped memory, {} of {} bytes are in use", m_offset, m_map_size);
+			return {nullptr, INVALID_OFFSET};
+		}
 
-	m_length++;
-	m_offset += m_element_size;
+		if (end > m_committed && !commit_until(end))
+		{
+			log::fatal("MemPool failed to commit memory up to {} bytes", end);
+			return {nullptr, INVALID_OFFSET};
+		}
 
-	if (construct && m_construct_func)
-	{
-		m_construct_func(out_mem);
+		offset = m_offset;
+		m_offset = end;
 	}
 
-	return {out_mem, mem_offset};
-}
-
-forge::MemPoolObject forge::MemPool::allocate(u32 count, bool construct)
-{
-	auto offset = m_offset;
-
 	auto *out_mem = m_memory + offset;
 
 	m_length += count;
-	m_offset += m_element_size * count;
+
+	if (m_relocate_func)
+	{
+		assign_handles(offset / m_element_size, count);
+
+		offset = m_slot_to_handle[offset / m_element_size] * m_element_size;
+	}
 
 	if (construct && m_construct_func)
 	{
 		auto *mem = out_mem;
 
-		for (auto i = 0; i < count; i++)
+		for (u32 i = 0; i < count; i++)
 		{
 			m_construct_func(mem);
 			mem += m_element_size;
@@ -84,41 +135,173 @@ forge::MemPoolObject forge::MemPool::allocate(u32 count, bool construct)
 
 void forge::MemPool::free(size_t offset_to_free, bool destroy)
 {
+	if (m_relocate_func)
+	{
+		const auto handle = offset_to_free / m_element_size;
+		const auto slot = m_handle_to_slot[handle];
+
+		assert(slot != INVALID_SLOT && "freeing an element that is already free");
+
+		m_handle_to_slot[handle] = INVALID_SLOT;
+		m_free_handles.push_back(handle);
+
+		offset_to_free = slot * m_element_size;
+	}
+
 	if (destroy && m_destroy_func)
 	{
 		m_destroy_func(m_memory + offset_to_free);
 	}
 
-	m_free_list.push_back(offset_to_free);
+	m_free_ranges.free(offset_to_free / m_element_size, 1);
+
+	// slots freed at the end go back to the bump allocator so iteration does not have to walk over them
+	if (auto range = m_free_ranges.pop_range_ending_at(get_slot_count()))
+	{
+		m_offset = range->first * m_element_size;
+
+		release_unused();
+	}
 
 	m_length--;
 }
 
 void forge::MemPool::free_at(size_t index, bool destroy)
 {
-	auto offset_to_free = m_element_size * index;
-
-	free(offset_to_free, destroy);
+	free(get_offset_of_index(index), destroy);
 }
 
 void forge::MemPool::reset(bool destroy, DestroyFunc on_destroy)
 {
 	if (destroy && m_destroy_func)
 	{
-		for (size_t i = 0; i < m_length; i++)
-		{
-			auto *ptr = m_memory + i * m_element_size;
+		size_t index = 0;
 
-			if (on_destroy)
+		auto destroy_until = [&](size_t end)
+		{
+			for (; index < end; index++)
 			{
-				on_destroy(ptr);
+				auto *ptr = m_memory + index * m_element_size;
+
+				if (on_destroy)
+				{
+					on_destroy(ptr);
+				}
+
+				m_destroy_func(ptr);
 			}
+		};
 
-			m_destroy_func(ptr);
+		// only the slots between the free ranges are alive
+		for (auto [first, count] : m_free_ranges.get_ranges())
+		{
+			destroy_until(first);
+			index = first + count;
 		}
+
+		destroy_until(get_slot_count());
 	}
 
 	m_offset = 0;
 	m_length = 0;
-	m_free_list.clear();
-}
\ No newline at end of file
+	m_free_ranges.clear();
+	release_unused();
+	m_handle_to_slot.clear();
+	m_slot_to_handle.clear();
+	m_free_handles.clear();
+}
+
+void forge::MemPool::set_compact(RelocateFunc relocate_func)
+{
+	assert(m_offset == 0 && "compact mode has to be set before anything is allocated");
+
+	m_relocate_func = relocate_func;
+}
+
+void forge::MemPool::compact()
+{
+	if (!m_relocate_func)
+	{
+		return;
+	}
+
+	// trailing free slots are popped in free, so the highest slot is always alive here
+	while (auto hole = m_free_ranges.allocate(1))
+	{
+		const auto last = get_slot_count() - 1;
+		const auto handle = m_slot_to_handle[last];
+
+		m_relocate_func(m_memory + *hole * m_element_size, m_memory + last * m_element_size);
+
+		m_slot_to_handle[*hole] = handle;
+		m_handle_to_slot[handle] = (u32)*hole;
+
+		m_offset -= m_element_size;
+
+		// moving the last element can leave free slots at the end again
+		if (auto range = m_free_ranges.pop_range_ending_at(get_slot_count()))
+		{
+			m_offset = range->first * m_element_size;
+		}
+	}
+
+	m_slot_to_handle.resize(get_slot_count());
+
+	release_unused();
+}
+
+void forge::MemPool::assign_handles(size_t first_slot, u32 count)
+{
+	if (m_slot_to_handle.size() < first_slot + count)
+	{
+		m_slot_to_handle.resize(first_slot + count);
+	}
+
+	for (auto slot = first_slot; slot < first_slot + count; slot++)
+	{
+		u32 handle;
+
+		if (m_free_handles.empty())
+		{
+			handle = (u32)m_handle_to_slot.size();
+			m_handle_to_slot.push_back((u32)slot);
+		}
+		else
+		{
+			handle = m_free_handles.back();
+			m_free_handles.pop_back();
+			m_handle_to_slot[handle] = (u32)slot;
+		}
+
+		m_slot_to_handle[slot] = handle;
+	}
+}
+
+bool forge::MemPool::commit_until(size_t size)
+{
+	const auto committed = std::min(align_to(size, get_commit_granularity()), m_map_size);
+
+	if (!virtual_commit(m_memory + m_committed, committed - m_committed, m_alloc_flags))
+	{
+		return false;
+	}
+
+	m_committed = committed;
+
+	return true;
+}
+
+void forge::MemPool::release_unused()
+{
+	const auto needed = align_to(m_offset, get_commit_granularity());
+	const auto unused = m_committed - std::min(needed, m_committed);
+
+	if (unused < MEMPOOL_DECOMMIT_THRESHOLD || unused < m_committed / 2)
+	{
+		return;
+	}
+
+	virtual_decommit(m_memory + needed, unused);
+
+	m_committed = needed;
+}
@@ -6,8 +6,19 @@
 #include "forge/container/array.hpp"
 #include "forge/container/view.hpp"
 #include "forge/core/logging.hpp"
+#include "forge/memory/defs.hpp"
+#include "forge/memory/free_range_list.hpp"
+#include "forge/system/virtual_alloc_flags.hpp"
 #include "forge/util/types.hpp"
 
+// pools reserve their whole map size up front and commit it in steps of this as they grow
+#define MEMPOOL_COMMIT_GRANULARITY KB(64)
+// used instead for pools that asked for huge pages, committing less would split the huge pages up
+#define MEMPOOL_HUGE_PAGE_COMMIT_GRANULARITY VIRTUAL_HUGE_PAGE_SIZE
+// committed memory is kept at the high water mark until at least this much of it and at least half of it is unused.
+// keeps pools that shrink and grow again from giving their pages back and faulting them in over and over
+#define MEMPOOL_DECOMMIT_THRESHOLD MB(1)
+
 namespace forge
 {
 	namespace MemPoolFlags
@@ -109,27 +120,41 @@ namespace forge
 		typedef void(*DestroyFunc)(u8*);
 		typedef void(*ConstructFunc)(u8*);
 		typedef void(*CreateIteratorFunc)(u8*);
+		// has to move the element at source into the uninitialized destination and destroy the one at source
+		typedef void(*RelocateFunc)(u8 *destination, u8 *source);
+
+		static constexpr u32 INVALID_SLOT = UINT32_MAX;
 
 	public:
+		// byte offset handed out together with a null pointer when an allocation does not fit
+		static constexpr size_t INVALID_OFFSET = SIZE_MAX;
+
 		MemPool() = default;
 		~MemPool();
 
-		bool init(size_t element_size, size_t map_size);
+		// moving hands the mapping over, copies would free it twice
+		MemPool(const MemPool &) = delete;
+		MemPool& operator=(const MemPool &) = delete;
+		MemPool(MemPool &&other) noexcept;
+		MemPool& operator=(MemPool &&other) noexcept;
+
+		// flags are passed on to virtual_alloc, see VirtualAllocFlags
+		bool init(size_t element_size, size_t map_size, u8 alloc_flags = VirtualAllocFlags::None);
 
 		template<class T>
-		bool init(size_t map_size)
+		bool init(size_t map_size, u8 alloc_flags = VirtualAllocFlags::None)
 		{
 			set_destructor<T>();
 			set_constructor<T>();
-			return init(sizeof(T), map_size);
+			return init(sizeof(T), map_size, alloc_flags);
 		}
 
 		void destroy();
 
+		// returns {nullptr, INVALID_OFFSET} when the pool runs out of mapped memory
 		MemPoolObject allocate(bool construct = false);
 
-		// Will allocate a contiguous sequence of memory
-		// TODO: make sure this eventually uses a freelist otherwise will run out of memory even though there is enough free memory
+		// Will allocate a contiguous sequence of memory, reusing a freed range if one is big enough
 		MemPoolObject allocate(u32 count, bool construct = false);
 
 		template<class T>
@@ -151,11 +176,42 @@ namespace forge
 			};
 		}
 
+		// switches the pool into compact mode, has to be called before anything is allocated.
+		// compact() can then move the highest elements into the holes left behind by free so iteration only has to
+		// visit live elements. offsets handed out in this mode are stable ids that get translated through an
+		// indirection table, so they stay the same when an element is moved
+		void set_compact(RelocateFunc relocate_func);
+
+		template<class T>
+		void set_compact()
+		{
+			set_compact([](u8 *destination, u8 *source)
+			{
+				new (destination) T(std::move(*(T*)source));
+				((T*)source)->~T();
+			});
+		}
+
+		// fills every hole with the highest element until the used slots are contiguous again. does nothing
+		// outside of compact mode. pointers to moved elements are invalid afterwards
+		void compact();
+
+		[[nodiscard]]
+		inline bool is_compact() const
+		{
+			return m_relocate_func != nullptr;
+		}
+
 		template<class T, class... Args>
 		std::pair<T*, size_t> emplace(Args ...args)
 		{
 			auto [mem, offset] = allocate(false);
 
+			if (mem == nullptr)
+			{
+				return {nullptr, offset};
+			}
+
 			return {new (mem) T(std::forward<Args>(args)...), offset};
 		}
 
@@ -167,6 +223,18 @@ namespace forge
 
 		inline u8* get(size_t offset)
 		{
+			if (m_relocate_func)
+			{
+				const auto handle = offset / m_element_size;
+
+				if (handle >= m_handle_to_slot.size() || m_handle_to_slot[handle] == INVALID_SLOT)
+				{
+					return nullptr;
+				}
+
+				offset = m_handle_to_slot[handle] * m_element_size;
+			}
+
 			if (offset >= m_offset)
 			{
 				return nullptr;
@@ -192,6 +260,17 @@ namespace forge
 			return (T*)get_from_index(index);
 		}
 
+		// the offset to pass to get and free for the element at index
+		inline size_t get_offset_of_index(size_t index) const
+		{
+			if (m_relocate_func)
+			{
+				return m_slot_to_handle[index] * m_element_size;
+			}
+
+			return index * m_element_size;
+		}
+
 		inline size_t get_length() const
 		{
 			return m_length;
@@ -202,6 +281,25 @@ namespace forge
 			return m_offset;
 		}
 
+		// the amount of slots below the highest one in use. this is what has to be iterated to visit every element,
+		// freed slots in between are included so users have to be able to tell them apart
+		inline size_t get_slot_count() const
+		{
+			return m_offset / m_element_size;
+		}
+
+		// the amount of bytes that are backed by usable memory
+		inline size_t get_committed_size() const
+		{
+			return m_committed;
+		}
+
+		// the amount of freed slots below the highest one in use
+		inline size_t get_free_count() const
+		{
+			return m_free_ranges.get_free_count();
+		}
+
 		inline size_t get_element_size() const
 		{
 			return m_element_size;
@@ -219,14 +317,35 @@ namespace forge
 		}
 
 	private:
-		u8 *m_memory;
-		size_t m_offset;
-		size_t m_length;
-		size_t m_element_size;
-		size_t m_map_size;
-		Array<size_t> m_free_list;
+		u8 *m_memory = nullptr;
+		size_t m_offset = 0;
+		size_t m_length = 0;
+		size_t m_element_size = 0;
+		size_t m_map_size = 0;
+		size_t m_committed = 0;
+		u8 m_alloc_flags = VirtualAllocFlags::None;
+		// in slots, not bytes. freed slots at the end are handed back by lowering m_offset instead
+		FreeRangeList m_free_ranges;
 		DestroyFunc m_destroy_func = nullptr;
 		ConstructFunc m_construct_func = nullptr;
+		// only set in compact mode
+		RelocateFunc m_relocate_func = nullptr;
+		// compact mode only. handles are offset / element size of what was handed out by allocate
+		Array<u32> m_handle_to_slot;
+		Array<u32> m_slot_to_handle;
+		Array<u32> m_free_handles;
+
+		void assign_handles(size_t first_slot, u32 count);
+
+		bool commit_until(size_t size);
+
+		inline size_t get_commit_granularity() const
+		{
+			return m_alloc_flags & VirtualAllocFlags::HugePages ? MEMPOOL_HUGE_PAGE_COMMIT_GRANULARITY : MEMPOOL_COMMIT_GRANULARITY;
+		}
+
+		// gives the committed pages above the offset back once the decommit threshold is reached
+		void release_unused();
 	};
 
 	template<class T>
@@ -238,7 +357,7 @@ namespace forge
 	template<class T>
 	MemPoolIterator<T> MemPoolTypedIterator<T>::end()
 	{
-		auto end_offset = m_mempool->get_length() * m_mempool->get_element_size();
+		auto end_offset = m_mempool->get_offset();
 		return {m_mempool->get_memory() + end_offset, m_mempool->get_element_size()};
 	}
 }
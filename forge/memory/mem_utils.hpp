@@ -1,7 +1,11 @@
 #pragma once
 
-inline size_t align_to(size_t value, size_t alignment)
+constexpr size_t align_to(size_t value, size_t alignment)
 {
 	return value + (alignment - 1) & ~(alignment - 1);
 }
 
+constexpr size_t align_down(size_t value, size_t alignment)
+{
+	return value & ~(alignment - 1);
+}
@@ -18,9 +18,25 @@ namespace forge
 			return (T*)virtual_alloc(n);
 		}
 
-		static u8* allocate_bytes(size_t n)
+		static u8* allocate_bytes(size_t n, u8 flags = VirtualAllocFlags::None)
 		{
-			return virtual_alloc(n);
+			return virtual_alloc(n, flags);
+		}
+
+		// only claims the address range, see virtual_reserve
+		static u8* reserve_bytes(size_t n, u8 flags = VirtualAllocFlags::None)
+		{
+			return virtual_reserve(n, flags);
+		}
+
+		static bool commit_bytes(u8* p, size_t n, u8 flags = VirtualAllocFlags::None)
+		{
+			return virtual_commit(p, n, flags);
+		}
+
+		static void decommit_bytes(u8* p, size_t n)
+		{
+			virtual_decommit(p, n);
 		}
 
 		static void deallocate(T* p, std::size_t n) noexcept
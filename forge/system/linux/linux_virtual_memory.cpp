@@ -1,27 +1,185 @@
 #include "linux_virtual_memory.hpp"
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <unistd.h>
 #include <cstring>
 
 #include "../system_info.hpp"
 #include "forge/memory/mem_utils.hpp"
 
-u8* forge::linux_virtual_alloc(size_t size)
+// where the mapping starts and how large it is are stored in front of the memory. they get a whole cache line to
+// themselves so the returned memory starts on a cache line boundary, which pools split across threads rely on
+#define VIRTUAL_MEMORY_HEADER_SIZE 64
+
+namespace
 {
-	constexpr auto n = sizeof(size_t);
+	struct MappingHeader
+	{
+		u8 *base;
+		size_t size;
+	};
+
+	static_assert(sizeof(MappingHeader) <= VIRTUAL_MEMORY_HEADER_SIZE);
+
+	// prefers the node of the cpu the calling thread currently runs on. preferred instead of bound so allocations
+	// still succeed once that node runs out of memory
+	void bind_to_local_node(u8 *ptr, size_t size)
+	{
+		unsigned cpu;
+		unsigned node;
 
-	size = align_to(size + n, get_page_size());
+		if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= sizeof(unsigned long) * 8)
+		{
+			return;
+		}
 
-	auto *ptr = (u8*)mmap(nullptr, size + n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		const unsigned long node_mask = 1ul << node;
 
-	if (ptr == (void *) -1)
+		syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8, 0);
+	}
+
+	void populate(u8 *ptr, size_t size)
 	{
+#ifdef MADV_POPULATE_WRITE
+		if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0)
+		{
+			return;
+		}
+#endif
+		// older kernels, touch every page by hand. written back as is since the range can hold data already
+		const auto page_size = get_page_size();
+
+		for (size_t offset = 0; offset < size; offset += page_size)
+		{
+			auto *byte = (volatile u8*)(ptr + offset);
+			*byte = *byte;
+		}
+	}
+}
+
+u8* forge::linux_virtual_alloc(size_t size, u8 flags)
+{
+	auto *ptr = linux_virtual_reserve(size, flags);
+
+	if (ptr != nullptr && !linux_virtual_commit(ptr, size, flags))
+	{
+		linux_virtual_free(ptr);
 		return nullptr;
 	}
 
-	memcpy(ptr, &size, n);
+	return ptr;
+}
+
+u8* forge::linux_virtual_reserve(size_t size, u8 flags)
+{
+	const auto page_size = get_page_size();
+	const auto is_huge = (flags & VirtualAllocFlags::HugePages) != 0;
+
+	// huge pages can only back 2MB aligned ranges. the memory handed out starts on such a boundary and the header
+	// gets the page in front of it, so committing and decommitting in huge page steps never splits one up
+	const auto header_size = is_huge ? page_size : VIRTUAL_MEMORY_HEADER_SIZE;
+
+	size = is_huge ? align_to(size, VIRTUAL_HUGE_PAGE_SIZE) : align_to(size + header_size, page_size) - header_size;
+
+	// large enough to fit the header page and the aligned memory wherever the mapping ends up
+	auto map_size = is_huge ? size + VIRTUAL_HUGE_PAGE_SIZE : size + header_size;
+
+	auto map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+	if (flags & VirtualAllocFlags::NoReserve)
+	{
+		map_flags |= MAP_NORESERVE;
+	}
+
+	auto *base = (u8*)mmap(nullptr, map_size, PROT_NONE, map_flags, -1, 0);
+
+	if (base == (void *) -1)
+	{
+		return nullptr;
+	}
+
+	auto *ptr = base + header_size;
+
+	if (is_huge)
+	{
+		ptr = (u8*)align_to((size_t)ptr, VIRTUAL_HUGE_PAGE_SIZE);
+
+		// give back what was only reserved to find the boundary
+		auto *end = ptr + size;
+		auto *map_end = base + map_size;
+
+		if (ptr - header_size > base)
+		{
+			munmap(base, ptr - header_size - base);
+		}
+
+		if (map_end > end)
+		{
+			munmap(end, map_end - end);
+		}
+
+		base = ptr - header_size;
+		map_size = size + header_size;
+
+		// only a hint and sticks to the range, so it applies to whatever gets committed later on
+		madvise(ptr, size, MADV_HUGEPAGE);
+	}
+
+	if (flags & VirtualAllocFlags::LocalNode)
+	{
+		bind_to_local_node(base, map_size);
+	}
+
+	auto *header_ptr = ptr - VIRTUAL_MEMORY_HEADER_SIZE;
+
+	// the page with the header always stays committed
+	mprotect((u8*)align_down((size_t)header_ptr, page_size), page_size, PROT_READ | PROT_WRITE);
+
+	const MappingHeader header {base, map_size};
+
+	memcpy(header_ptr, &header, sizeof(header));
+
+	return ptr;
+}
+
+bool forge::linux_virtual_commit(u8 *ptr, size_t size, u8 flags)
+{
+	const auto page_size = get_page_size();
+
+	auto *first = (u8*)align_down((size_t)ptr, page_size);
+	auto *last = (u8*)align_to((size_t)(ptr + size), page_size);
+
+	if (mprotect(first, last - first, PROT_READ | PROT_WRITE) != 0)
+	{
+		return false;
+	}
+
+	if (flags & VirtualAllocFlags::Populate)
+	{
+		populate(first, last - first);
+	}
+
+	return true;
+}
+
+void forge::linux_virtual_decommit(u8 *ptr, size_t size)
+{
+	const auto page_size = get_page_size();
+
+	auto *first = (u8*)align_to((size_t)ptr, page_size);
+	auto *last = (u8*)align_down((size_t)(ptr + size), page_size);
+
+	if (last <= first)
+	{
+		return;
+	}
 
-	return ptr + n;
+	// drops the pages right away, they come back zeroed if the range gets committed again
+	madvise(first, last - first, MADV_DONTNEED);
+	mprotect(first, last - first, PROT_NONE);
 }
 
 void forge::linux_virtual_free(u8* ptr)
@@ -31,7 +189,8 @@ void forge::linux_virtual_free(u8* ptr)
 		return;
 	}
 
-	auto size = (size_t)(ptr - sizeof(size_t));
+	MappingHeader header;
+	memcpy(&header, ptr - VIRTUAL_MEMORY_HEADER_SIZE, sizeof(header));
 
-	munmap(ptr, size);
+	munmap(header.base, header.size);
 }
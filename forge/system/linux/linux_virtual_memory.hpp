@@ -2,8 +2,14 @@
 
 #include <cstddef>
 
+#include "../virtual_alloc_flags.hpp"
+
 namespace forge
 {
-	u8* linux_virtual_alloc(size_t size);
+	u8* linux_virtual_alloc(size_t size, u8 flags = VirtualAllocFlags::None);
 	void linux_virtual_free(u8 *ptr);
-}
\ No newline at end of file
+
+	u8* linux_virtual_reserve(size_t size, u8 flags = VirtualAllocFlags::None);
+	bool linux_virtual_commit(u8 *ptr, size_t size, u8 flags = VirtualAllocFlags::None);
+	void linux_virtual_decommit(u8 *ptr, size_t size);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "forge/memory/defs.hpp"
+#include "forge/util/types.hpp"
+
+// the size of a transparent huge page. ranges reserved with HugePages start on a boundary of it
+#define VIRTUAL_HUGE_PAGE_SIZE MB(2)
+
+namespace forge
+{
+	namespace VirtualAllocFlags
+	{
+		enum : u8
+		{
+			None = 0,
+			// asks for transparent huge pages so large pools need far fewer tlb entries.
+			// memory is faulted in 2MB at a time so only use it for pools that actually get filled
+			HugePages = 1 << 0,
+			// don't reserve swap for the mapping, for large reservations that are mostly never touched
+			NoReserve = 1 << 1,
+			// faults pages in as soon as they are committed instead of on first touch
+			Populate = 1 << 2,
+			// places the pages on the numa node of the calling thread, which is expected to be the one using them
+			LocalNode = 1 << 3,
+		};
+	}
+}
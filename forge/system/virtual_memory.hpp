@@ -1,11 +1,19 @@
 #pragma once
 
+// virtual_alloc returns memory that can be used right away. virtual_reserve only claims the address range,
+// parts of it have to be made usable with virtual_commit and can be given back to the os with virtual_decommit.
+// both round to whole pages, commit outwards and decommit inwards so neighbouring memory stays intact.
+// virtual_free releases either of them
+
 #if __linux__
 #include "linux/linux_virtual_memory.hpp"
 namespace forge
 {
 	#define virtual_alloc linux_virtual_alloc
 	#define virtual_free linux_virtual_free
+	#define virtual_reserve linux_virtual_reserve
+	#define virtual_commit linux_virtual_commit
+	#define virtual_decommit linux_virtual_decommit
 }
 #else
 #error unsupported platform for virtual memory